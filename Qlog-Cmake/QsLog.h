@@ -1,125 +1,468 @@
-﻿#ifndef QSLOG_H
-#define QSLOG_H
-
-#include "QsLogLevel.h"
-#include "QsLogDest.h"
-#include <QDebug>
-#include <QString>
-#include <QSharedPointer>
-#include <QVector>
-#include <QMutex>
-#include <QThreadPool>
-#include <QWaitCondition>
-#include <atomic>
-
-namespace QsLogging
-{
-class LoggerImpl;
-
-// Logger 单例类
-class Logger
-{
-public:
-    // 获取 Logger 单例的静态方法
-    static Logger& instance();
-    // 销毁 Logger 单例的静态方法
-    static void destroyInstance();
-    // 析构函数
-    ~Logger();
-
-    // 强制同步写入所有待处理的日志。
-    void flush();
-
-    //添加一个日志消息目标。不能添加空指针。
-    void addDestination(DestinationPtr destination);
-    //设置日志级别，低于该级别的日志将被忽略。
-    void setLoggingLevel(Level newLevel);
-    //获取当前日志级别，默认级别为 INFO
-    Level loggingLevel() const;
-    //设置是否在日志消息中包含时间戳
-    void setIncludeTimestamp(bool e);
-    //获取是否包含时间戳，默认为 true。
-    bool includeTimestamp() const;
-    //设置是否在日志消息中包含日志级别
-    void setIncludeLogLevel(bool l);
-    //获取是否包含日志级别，默认为 true。
-    bool includeLogLevel() const;
-
-    //Helper 类，用于将流式日志重定向到 QDebug 并构建最终的日志消息。
-    class Helper
-    {
-    public:
-        // 接收日志级别
-        explicit Helper(Level logLevel) :
-            level(logLevel), qtDebug(new QDebug(&buffer)) {}
-        // 负责将日志消息发送给 Logger
-        ~Helper();
-        // 获取 QDebug 流，用于写入日志内容
-        QDebug& stream(){ return *qtDebug; }
-
-    private:
-        Level level;
-        QString buffer;
-        QSharedPointer<QDebug> qtDebug;
-    };
-
-private:
-    // 构造函数私有，防止外部实例化
-    Logger();
-    // 禁用拷贝构造函数
-    Logger(const Logger&);
-    // 禁用赋值操作符
-    Logger& operator=(const Logger&);
-
-    LoggerImpl* d; // 指向实现类的指针
-};
-
-} // end namespace QsLogging
-
-//日志宏定义：如果定义了 QS_LOG_LINE_NUMBERS，日志输出将包含文件和行号。
-#ifndef QS_LOG_LINE_NUMBERS
-#define QLOG_TRACE() \
-    if (QsLogging::Logger::instance().loggingLevel() > QsLogging::TraceLevel) {} \
-    else QsLogging::Logger::Helper(QsLogging::TraceLevel).stream()
-#define QLOG_DEBUG() \
-    if (QsLogging::Logger::instance().loggingLevel() > QsLogging::DebugLevel) {} \
-    else QsLogging::Logger::Helper(QsLogging::DebugLevel).stream()
-#define QLOG_INFO()  \
-    if (QsLogging::Logger::instance().loggingLevel() > QsLogging::InfoLevel) {} \
-    else QsLogging::Logger::Helper(QsLogging::InfoLevel).stream()
-#define QLOG_WARN()  \
-    if (QsLogging::Logger::instance().loggingLevel() > QsLogging::WarnLevel) {} \
-    else QsLogging::Logger::Helper(QsLogging::WarnLevel).stream()
-#define QLOG_ERROR() \
-    if (QsLogging::Logger::instance().loggingLevel() > QsLogging::ErrorLevel) {} \
-    else QsLogging::Logger::Helper(QsLogging::ErrorLevel).stream()
-#define QLOG_FATAL() \
-    if (QsLogging::Logger::instance().loggingLevel() > QsLogging::FatalLevel) {} \
-    else QsLogging::Logger::Helper(QsLogging::FatalLevel).stream()
-#else
-// 定义了 QS_LOG_LINE_NUMBERS 的宏，包含文件和行号
-#define QLOG_TRACE() \
-    if (QsLogging::Logger::instance().loggingLevel() > QsLogging::TraceLevel) {} \
-    else QsLogging::Logger::Helper(QsLogging::TraceLevel).stream() << __FILE__ << '@' << __LINE__
-#define QLOG_DEBUG() \
-    if (QsLogging::Logger::instance().loggingLevel() > QsLogging::DebugLevel) {} \
-    else QsLogging::Logger::Helper(QsLogging::DebugLevel).stream() << __FILE__ << '@' << __LINE__
-#define QLOG_INFO()  \
-    if (QsLogging::Logger::instance().loggingLevel() > QsLogging::InfoLevel) {} \
-    else QsLogging::Logger::Helper(QsLogging::InfoLevel).stream() << __FILE__ << '@' << __LINE__
-#define QLOG_WARN()  \
-    if (QsLogging::Logger::instance().loggingLevel() > QsLogging::WarnLevel) {} \
-    else QsLogging::Logger::Helper(QsLogging::WarnLevel).stream() << __FILE__ << '@' << __LINE__
-#define QLOG_ERROR() \
-    if (QsLogging::Logger::instance().loggingLevel() > QsLogging::ErrorLevel) {} \
-    else QsLogging::Logger::Helper(QsLogging::ErrorLevel).stream() << __FILE__ << '@' << __LINE__
-#define QLOG_FATAL() \
-    if (QsLogging::Logger::instance().loggingLevel() > QsLogging::FatalLevel) {} \
-    else QsLogging::Logger::Helper(QsLogging::FatalLevel).stream() << __FILE__ << '@' << __LINE__
-#endif
-
-#ifdef QS_LOG_DISABLE
-#include "QsLogDisableForThisFile.h"
-#endif
-
-#endif // QSLOG_H
+﻿#ifndef QSLOG_H
+#define QSLOG_H
+
+#include "QsLogLevel.h"
+#include "QsLogDest.h"
+#include "QsLogArguments.h"
+#include "QsLogFormat.h"
+#include "QsLogRecord.h"
+#include "QsLogSite.h"
+#include "QsLogLimiter.h"
+#include "QsLogCategory.h"
+#include "QsLogClock.h"
+#include <QDebug>
+#include <QFuture>
+#include <QString>
+#include <QSharedPointer>
+#include <QVector>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+
+namespace QsLogging
+{
+class LoggerImpl;
+struct FormatBuffer;
+
+// 日志从调用点产生到所有目的地写入完成之间的延迟统计
+struct QSLOG_SHARED_OBJECT LatencyStatistics
+{
+    LatencyStatistics() : count(0), totalNanoseconds(0), maxNanoseconds(0) {}
+
+    quint64 count;           // 统计的日志条数
+    qint64 totalNanoseconds; // 延迟总和（纳秒）
+    qint64 maxNanoseconds;   // 最大延迟（纳秒）
+};
+
+// 关闭日志系统时写出剩余日志的结果
+struct QSLOG_SHARED_OBJECT ShutdownReport
+{
+    ShutdownReport() : written(0), dropped(0), timedOut(false), synced(true), elapsedMilliseconds(0) {}
+
+    quint64 written;            // 关闭时仍在队列中、随后被写出的记录数
+    quint64 dropped;            // 超过期限仍未写出而被丢弃的记录数
+    bool timedOut;              // 是否在写完之前到达期限
+    bool synced;                // 最后一次同步所有目的地是否成功
+    qint64 elapsedMilliseconds; // 关闭所用的时间
+};
+
+// 队列已满或超出预算时的处理策略
+enum OverflowPolicy
+{
+    BlockOnOverflow = 0,      // 阻塞等待写入线程腾出空间，超时后丢弃新消息
+    DropNewestOnOverflow,     // 立即丢弃新消息
+    DropOldestOnOverflow,     // 新消息照常入队，由写入线程丢弃已满缓冲区或全部队列中最早的消息
+    DropBelowLevelOnOverflow  // 丢弃低于指定级别的新消息，其余消息按 BlockOnOverflow 处理
+};
+// 达到同步级别（见 Logger::setSynchronousLevel()）的消息不受丢弃策略影响：溢出时最多等待同步写入的期限，
+// 也不会被 DropOldestOnOverflow 丢弃
+
+// 日志写入线程的调度设置，由写入线程在自己身上应用，不支持或失败的项输出警告后忽略
+struct QSLOG_SHARED_OBJECT WriterThreadOptions
+{
+    WriterThreadOptions() :
+        name(QString("QsLogWriter")),
+        priority(QThread::InheritPriority),
+        niceValue(0),
+        cpuAffinityMask(0)
+    {}
+
+    QString name;              // 线程名称，在 top、perf 等工具中可见（Linux 上截断为 15 字节），空字符串表示不修改
+    QThread::Priority priority; // Qt 线程优先级，InheritPriority 表示不修改。Linux 的普通调度策略下只有 IdlePriority 生效
+    int niceValue;             // Linux 上线程的 nice 值（-20 到 19，降低需要权限），0 表示不修改
+    quint64 cpuAffinityMask;   // CPU 亲和性掩码，第 i 位对应第 i 个 CPU，0 表示不修改；macOS 上不支持
+};
+
+// Logger 单例类
+class QSLOG_SHARED_OBJECT Logger
+{
+public:
+    // 获取 Logger 单例的静态方法，实例发布后的调用不加锁。destroyInstance() 之后返回已关闭的单例，不会重新创建
+    static Logger& instance();
+    // 判断指定级别的日志是否需要输出。日志宏内联调用此函数，
+    // 被过滤的日志只需一次 relaxed 原子读取和一次比较，也不会触发单例的创建
+    static bool isLevelEnabled(Level level)
+    {
+        return static_cast<int>(level) >= s_loggingLevel.load(std::memory_order_relaxed);
+    }
+    // 销毁 Logger 单例的静态方法：在期限内写完队列中剩余的日志并同步所有目的地，返回写出与丢弃的条数。
+    // 单例创建时会登记 atexit 钩子，进程退出时自动调用；若此时 QCoreApplication 已存在，
+    // 还会在 aboutToQuit 时先按同一期限刷新一次，趁 Qt 各模块仍然可用时写完已有的日志。
+    // 关闭是终止状态：开始前已在进行的日志调用照常写出，之后的日志调用计入 droppedMessageCount()；
+    // 单例对象保留到进程结束，日志目的地在关闭后释放。重复调用返回空的结果
+    static ShutdownReport destroyInstance();
+    // 设置当前线程在日志记录中的名称。默认使用线程第一次写日志时 QThread 的 objectName()
+    static void setThreadName(const QString& name);
+    // 析构函数
+    ~Logger();
+
+    // 等待调用前写入的所有日志交给每个目的地并同步（Destination::sync()）完成，
+    // 所有目的地都同步成功时返回 true。timeoutMs 小于 0 表示一直等待，超时返回 false（请求仍会在稍后完成）
+    bool flush(int timeoutMs = -1);
+    // flush() 的非阻塞版本：立即返回，记录持久化后 QFuture 完成，结果与 flush() 的返回值相同
+    QFuture<bool> flushAsync();
+    // 已写入并同步到所有目的地的最大记录序号（见 LogRecord::sequence()），每次刷新完成时推进
+    quint64 committedSequence() const;
+
+    //添加一个日志消息目标。不能添加空指针。
+    void addDestination(DestinationPtr destination);
+    //设置日志级别，低于该级别的日志将被忽略。
+    void setLoggingLevel(Level newLevel);
+    //获取当前日志级别，默认级别为 INFO
+    Level loggingLevel() const;
+    //设置是否在日志消息中包含时间戳
+    void setIncludeTimestamp(bool e);
+    //获取是否包含时间戳，默认为 true。
+    bool includeTimestamp() const;
+    //设置是否在日志消息中包含日志级别
+    void setIncludeLogLevel(bool l);
+    //获取是否包含日志级别，默认为 true。
+    bool includeLogLevel() const;
+    //设置汇总限流日志宏被抑制次数和队列溢出丢弃次数的间隔（毫秒），0 表示不汇总
+    void setSuppressionReportInterval(int msecs);
+    //获取汇总间隔，默认为 60000 毫秒
+    int suppressionReportInterval() const;
+    //设置关闭时写完剩余日志的期限（毫秒），小于 0 表示一直等到写完
+    void setShutdownTimeout(int msecs);
+    //获取关闭期限，默认为 5000 毫秒
+    int shutdownTimeout() const;
+    //设置同步写入的级别：达到该级别的日志在日志宏返回前先等待此前入队的日志，再连同它一起写入并同步
+    //所有目的地（与 flush() 相同），紧随其后的 abort() 不会使它丢失。timeoutMs 为最长等待时间，小于 0 表示一直等待。
+    //默认为 OffLevel，所有日志都异步写入；在写入线程上（例如日志目的地自己写日志）不会等待
+    void setSynchronousLevel(Level level, int timeoutMs = -1);
+    //获取同步写入的级别
+    Level synchronousLevel() const;
+    //设置队列中待写入消息的总条数和总字节数上限，0 表示不限制（默认均为 0）。
+    //每个线程的暂存缓冲区本身也有固定容量，写满时同样按溢出策略处理。
+    void setQueueLimits(int maxMessages, qint64 maxBytes);
+    //设置溢出策略。blockTimeoutMs 为阻塞等待的最长时间，小于 0 表示一直等待；
+    //dropBelowLevel 仅用于 DropBelowLevelOnOverflow。默认一直阻塞，不丢弃消息。
+    void setOverflowPolicy(OverflowPolicy policy, int blockTimeoutMs = -1, Level dropBelowLevel = WarnLevel);
+    //获取当前的溢出策略
+    OverflowPolicy overflowPolicy() const;
+    //获取自上次重置以来因队列溢出或在关闭之后写入而丢弃的指定级别的消息数
+    quint64 droppedMessageCount(Level level) const;
+    //重置丢弃计数
+    void resetDroppedMessageCounts();
+    //获取自上次重置以来的端到端写入延迟统计
+    LatencyStatistics latencyStatistics() const;
+    //重置延迟统计
+    void resetLatencyStatistics();
+    //启用或停用外部排空模式，默认停用。启用后内部写入线程休眠，日志产生时 notificationHandle() 变为可读，
+    //由调用方（通常是已有的事件循环）调用 processPendingMessages() 在自己的线程上写出日志。
+    //通知句柄创建失败时返回 false，保持原模式不变
+    bool setExternalDrainEnabled(bool enabled);
+    //是否处于外部排空模式
+    bool externalDrainEnabled() const;
+    //外部排空模式的通知句柄：Linux 上为 eventfd，其他 Unix 系统上为管道的读端，可交给 QSocketNotifier 监听；
+    //Windows 上为事件对象的 HANDLE，可交给 QWinEventNotifier 监听。第一次调用时创建，创建失败时返回 -1
+    qintptr notificationHandle();
+    //在调用线程上写出所有待处理的日志，返回写出的条数。外部排空模式下还会清除通知并重新等待下一次通知
+    int processPendingMessages();
+    //启用持久化日志环（见 QsLogJournal.h）：日志调用在入队前把记录写入内存映射文件，进程被杀死后可以找回。
+    //文件中仍有上次运行留下、尚未恢复的记录时不会清空它，输出警告后返回 false，
+    //应先调用 Journal::recoverIntoDatabase() 恢复这些记录。capacity 为保留最近记录的字节数，文件创建或映射失败时也返回 false。
+    //已启用的日志环先按 disableJournal() 停用，因此可以在同一个文件上重新启用
+    bool enableJournal(const QString& journalFilePath, qint64 capacity = 16 * 1024 * 1024);
+    //停用持久化日志环，文件保留，其中的记录标记为无需恢复。会等待写入线程取出所有已写入日志环的消息（与 flush() 相同）
+    //再解除映射，不能在写入线程上调用（例如在日志目的地中），此时输出警告后保持启用
+    void disableJournal();
+    //设置日志写入线程的名称、优先级、nice 值与 CPU 亲和性，例如把写入线程固定到处理请求的线程之外的核心上。
+    //写入线程在下一次取出消息前应用，休眠中的写入线程会被唤醒；已设置的项不会因后续设置为"不修改"而恢复
+    void setWriterThreadOptions(const WriterThreadOptions& options);
+    //获取最近一次设置的写入线程调度设置
+    WriterThreadOptions writerThreadOptions() const;
+
+    //Helper 类，用于将流式日志重定向到 QDebug 并构建最终的日志消息。
+    //格式化使用当前线程复用的缓冲区和 QDebug，常规路径上不会为每条日志创建新的对象。
+    class QSLOG_SHARED_OBJECT Helper
+    {
+    public:
+        // 接收日志级别与调用点信息，记录时间戳，并绑定当前线程的格式化缓冲区
+        explicit Helper(Level logLevel, const LogSite* logSite = nullptr);
+        // 负责将日志消息发送给 Logger
+        ~Helper();
+        // 获取 QDebug 流，用于写入日志内容
+        QDebug& stream(){ return *qtDebug; }
+        // 获取原始模式的 QDebug 流：不自动插入空格、不给字符串加引号，也不裁剪首尾空白
+        QDebug& rawStream(){ raw = true; return qtDebug->noquote().nospace(); }
+        // 获取延迟格式化流：只记录参数的类型与取值，由写入线程完成格式化
+        DeferredStream& deferredStream();
+        // 获取原始模式的延迟格式化流
+        DeferredStream& rawDeferredStream();
+        // 获取结构化日志流：message 为消息文本，字段通过 kv() 添加，均以类型化的值进入队列
+        template <typename T>
+        StructuredStream& stream(const T& message) { return beginStructured(message); }
+        // 结构化日志不区分是否延迟格式化，提供同名重载供 QS_LOG_DEFERRED_FORMAT 下的日志宏使用
+        template <typename T>
+        StructuredStream& deferredStream(const T& message) { return beginStructured(message); }
+        // 按格式字符串输出：参数依次填入 "{}" 占位符，在调用线程上直接生成文本。
+        // Placeholders 为日志宏在编译期统计的占位符个数，与参数个数不一致时编译失败
+        template <int Placeholders, typename... Args>
+        void format(const char* formatString, const Args&... args)
+        {
+            static_assert(Placeholders >= 0,
+                          "QLOG_*F: unmatched '{' or '}' in format string, use {{ and }} for literal braces");
+            static_assert(Placeholders < 0 || Placeholders == static_cast<int>(sizeof...(Args)),
+                          "QLOG_*F: the number of {} placeholders does not match the number of arguments");
+            FormatWriter writer = formatWriter();
+            formatArguments(writer, formatString, args...);
+        }
+
+    private:
+        Helper(const Helper&);
+        Helper& operator=(const Helper&);
+
+        template <typename T>
+        StructuredStream& beginStructured(const T& message)
+        {
+            StructuredStream& fields = structuredStream();
+            fields.begin(message);
+            return fields;
+        }
+        // 切换到结构化模式并返回缓冲区中复用的结构化日志流
+        StructuredStream& structuredStream();
+        // 切换到原始模式并返回写入缓冲区文本的格式化输出器
+        FormatWriter formatWriter();
+
+        Level level;
+        const LogSite* site;    // 调用点的静态信息，可能为空
+        qint64 timestamp;       // 调用点的时间戳（单调时钟纳秒）
+        bool raw;               // 是否使用原始模式
+        bool deferred;          // 是否使用延迟格式化
+        bool structured;        // 是否为结构化日志
+        bool ownsBuffer;        // 缓冲区是否为嵌套日志临时创建
+        FormatBuffer* buffer;   // 本条日志使用的格式化缓冲区
+        QDebug* qtDebug;        // 缓冲区中复用的 QDebug
+    };
+
+private:
+    // 构造函数私有，防止外部实例化
+    Logger();
+    // 禁用拷贝构造函数
+    Logger(const Logger&);
+    // 禁用赋值操作符
+    Logger& operator=(const Logger&);
+
+    static std::atomic<int> s_loggingLevel; // 当前日志级别，供日志宏跨动态库边界直接读取
+    LoggerImpl* d; // 指向实现类的指针
+};
+
+// 被编译期移除的日志语句使用的空流，写入的任何内容都会被忽略
+class NullStream
+{
+public:
+    template <typename T>
+    NullStream& operator<<(const T&) { return *this; }
+    template <typename T>
+    NullStream& kv(const char*, const T&) { return *this; }
+    NullStream& space() { return *this; }
+    NullStream& nospace() { return *this; }
+    NullStream& maybeSpace() { return *this; }
+    NullStream& quote() { return *this; }
+    NullStream& noquote() { return *this; }
+};
+
+} // end namespace QsLogging
+
+//编译期最低日志级别，取值与 Level 枚举一致（0=TRACE ... 6=OFF）。
+//低于该级别的日志宏展开为永不执行的空语句，不产生分支、字符串常量，也不会对参数求值。
+//可以在工程文件中为每个目标单独指定，例如 QS_LOG_COMPILE_LEVEL=2 只保留 INFO 及以上级别。
+#ifndef QS_LOG_COMPILE_LEVEL
+#define QS_LOG_COMPILE_LEVEL 0
+#endif
+
+#define QS_LOG_STRIPPED() \
+    if (true) {} \
+    else QsLogging::NullStream()
+
+//日志宏定义：每个调用点首次执行时登记文件、行号、函数等静态信息，日志消息只携带调用点指针。
+//如果定义了 QS_LOG_LINE_NUMBERS，文本输出时由写入线程在消息前加上文件和行号。
+//QLOG_XXX_RAW() 使用原始模式，输出内容与流入的内容完全一致。
+//QLOG_XXX("消息").kv("键", 值) 为结构化日志：消息和字段以类型化的值进入队列，目的地直接收到字段。
+//如果定义了 QS_LOG_DEFERRED_FORMAT，日志宏只在调用线程记录参数，格式化交给写入线程完成。
+#define QS_LOG_IF_ENABLED(level) \
+    if (!QsLogging::Logger::isLevelEnabled(level)) {} \
+    else
+#ifndef QS_LOG_LINE_NUMBERS
+#define QS_LOG_SITE_FLAGS QsLogging::LogSite::NoFlags
+#else
+#define QS_LOG_SITE_FLAGS QsLogging::LogSite::ShowLocation
+#endif
+#ifndef QS_LOG_DEFERRED_FORMAT
+#define QS_LOG_HELPER_STREAM(level, site, ...) QsLogging::Logger::Helper(level, site).stream(__VA_ARGS__)
+#define QS_LOG_HELPER_RAW_STREAM(level, site)  QsLogging::Logger::Helper(level, site).rawStream()
+#else
+#define QS_LOG_HELPER_STREAM(level, site, ...) QsLogging::Logger::Helper(level, site).deferredStream(__VA_ARGS__)
+#define QS_LOG_HELPER_RAW_STREAM(level, site)  QsLogging::Logger::Helper(level, site).rawDeferredStream()
+#endif
+#define QS_LOG_STREAM(level, ...) \
+    QS_LOG_IF_ENABLED(level) \
+    QS_LOG_HELPER_STREAM(level, QS_LOG_SITE(level, nullptr, QS_LOG_SITE_FLAGS), __VA_ARGS__)
+#define QS_LOG_RAW_STREAM(level) \
+    QS_LOG_IF_ENABLED(level) \
+    QS_LOG_HELPER_RAW_STREAM(level, QS_LOG_SITE(level, nullptr, QS_LOG_SITE_FLAGS))
+
+//类别日志宏：检查类别自身的级别，与全局级别无关
+#define QS_LOG_CATEGORY_STREAM(category, level) \
+    if (!(category).isLevelEnabled(level)) {} \
+    else QS_LOG_HELPER_STREAM(level, QS_LOG_CATEGORY_SITE((category).name(), level, nullptr, QS_LOG_SITE_FLAGS), )
+
+//格式化日志宏：QLOG_XXXF("conn {} took {} us", id, us)。格式字符串必须是字符串字面量，
+//占位符个数在编译期与参数个数比对；数字使用自带的转换，不经过 QTextStream，也不插入空格和引号。
+//格式字符串同时登记为调用点的 format，参数总是在调用线程上格式化，不受 QS_LOG_DEFERRED_FORMAT 影响。
+#define QS_LOG_EXPAND(x) x
+#define QS_LOG_FORMAT_STRING(...) QS_LOG_EXPAND(QS_LOG_FORMAT_STRING_IMPL(__VA_ARGS__, ))
+#define QS_LOG_FORMAT_STRING_IMPL(format, ...) format
+#define QS_LOG_FORMAT_STREAM(level, ...) \
+    QS_LOG_IF_ENABLED(level) \
+    QsLogging::Logger::Helper(level, QS_LOG_SITE(level, QS_LOG_FORMAT_STRING(__VA_ARGS__), QS_LOG_SITE_FLAGS)) \
+        .format<QsLogging::countPlaceholders(QS_LOG_FORMAT_STRING(__VA_ARGS__))>(__VA_ARGS__)
+
+//限流日志宏：每个调用点持有一个静态的限流器（见 QsLogLimiter.h）。
+//被抑制时只累加调用点的计数，不会构造 Helper，也不会对流入的参数求值。
+#define QS_LOG_LIMITED_SITE(level, Limiter, parameter) \
+    [](const char* qsLogFunction, QsLogging::Limiter::Parameter qsLogParameter) -> const QsLogging::LogSite* { \
+        static QsLogging::Limiter qsLogLimiter; \
+        static constexpr const char* qsLogFile = QS_LOG_FILE; \
+        static const QsLogging::LogSite* const qsLogSite = QsLogging::LogSiteRegistry::registerSite( \
+            qsLogFile, __LINE__, qsLogFunction, level, nullptr, QS_LOG_SITE_FLAGS | QsLogging::LogSite::RateLimited, nullptr); \
+        if (qsLogLimiter.allow(qsLogParameter)) { \
+            return qsLogSite; \
+        } \
+        qsLogSite->suppressed.fetch_add(1, std::memory_order_relaxed); \
+        return nullptr; \
+    }(Q_FUNC_INFO, parameter)
+//使用 for 语句代替 if，避免宏后面紧跟 else 时产生悬挂 else 问题
+#define QS_LOG_LIMITED_STREAM(level, Limiter, parameter) \
+    QS_LOG_IF_ENABLED(level) \
+    for (const QsLogging::LogSite* qsLogLimitedSite = QS_LOG_LIMITED_SITE(level, Limiter, parameter); \
+         qsLogLimitedSite; qsLogLimitedSite = nullptr) \
+        QS_LOG_HELPER_STREAM(level, qsLogLimitedSite, )
+
+#if QS_LOG_COMPILE_LEVEL > 0
+#define QLOG_TRACE(...)  QS_LOG_STRIPPED()
+#define QLOG_TRACE_RAW() QS_LOG_STRIPPED()
+#define QLOG_TRACEF(...) QS_LOG_STRIPPED()
+#define QLOG_TRACE_EVERY_N(n)     QS_LOG_STRIPPED()
+#define QLOG_TRACE_EVERY_MS(ms)   QS_LOG_STRIPPED()
+#define QLOG_TRACE_SAMPLED(rate)  QS_LOG_STRIPPED()
+#define QLOG_TRACE_ONCE()         QS_LOG_STRIPPED()
+#define QLOG_CAT_TRACE(category)    QS_LOG_STRIPPED()
+#else
+#define QLOG_TRACE(...)  QS_LOG_STREAM(QsLogging::TraceLevel, __VA_ARGS__)
+#define QLOG_TRACE_RAW() QS_LOG_RAW_STREAM(QsLogging::TraceLevel)
+#define QLOG_TRACEF(...) QS_LOG_FORMAT_STREAM(QsLogging::TraceLevel, __VA_ARGS__)
+#define QLOG_TRACE_EVERY_N(n)     QS_LOG_LIMITED_STREAM(QsLogging::TraceLevel, EveryNLimiter, n)
+#define QLOG_TRACE_EVERY_MS(ms)   QS_LOG_LIMITED_STREAM(QsLogging::TraceLevel, IntervalLimiter, ms)
+#define QLOG_TRACE_SAMPLED(rate)  QS_LOG_LIMITED_STREAM(QsLogging::TraceLevel, SampleLimiter, rate)
+#define QLOG_TRACE_ONCE()         QS_LOG_LIMITED_STREAM(QsLogging::TraceLevel, OnceLimiter, 0)
+#define QLOG_CAT_TRACE(category)    QS_LOG_CATEGORY_STREAM(category, QsLogging::TraceLevel)
+#endif
+
+#if QS_LOG_COMPILE_LEVEL > 1
+#define QLOG_DEBUG(...)  QS_LOG_STRIPPED()
+#define QLOG_DEBUG_RAW() QS_LOG_STRIPPED()
+#define QLOG_DEBUGF(...) QS_LOG_STRIPPED()
+#define QLOG_DEBUG_EVERY_N(n)     QS_LOG_STRIPPED()
+#define QLOG_DEBUG_EVERY_MS(ms)   QS_LOG_STRIPPED()
+#define QLOG_DEBUG_SAMPLED(rate)  QS_LOG_STRIPPED()
+#define QLOG_DEBUG_ONCE()         QS_LOG_STRIPPED()
+#define QLOG_CAT_DEBUG(category)    QS_LOG_STRIPPED()
+#else
+#define QLOG_DEBUG(...)  QS_LOG_STREAM(QsLogging::DebugLevel, __VA_ARGS__)
+#define QLOG_DEBUG_RAW() QS_LOG_RAW_STREAM(QsLogging::DebugLevel)
+#define QLOG_DEBUGF(...) QS_LOG_FORMAT_STREAM(QsLogging::DebugLevel, __VA_ARGS__)
+#define QLOG_DEBUG_EVERY_N(n)     QS_LOG_LIMITED_STREAM(QsLogging::DebugLevel, EveryNLimiter, n)
+#define QLOG_DEBUG_EVERY_MS(ms)   QS_LOG_LIMITED_STREAM(QsLogging::DebugLevel, IntervalLimiter, ms)
+#define QLOG_DEBUG_SAMPLED(rate)  QS_LOG_LIMITED_STREAM(QsLogging::DebugLevel, SampleLimiter, rate)
+#define QLOG_DEBUG_ONCE()         QS_LOG_LIMITED_STREAM(QsLogging::DebugLevel, OnceLimiter, 0)
+#define QLOG_CAT_DEBUG(category)    QS_LOG_CATEGORY_STREAM(category, QsLogging::DebugLevel)
+#endif
+
+#if QS_LOG_COMPILE_LEVEL > 2
+#define QLOG_INFO(...)   QS_LOG_STRIPPED()
+#define QLOG_INFO_RAW()  QS_LOG_STRIPPED()
+#define QLOG_INFOF(...)  QS_LOG_STRIPPED()
+#define QLOG_INFO_EVERY_N(n)     QS_LOG_STRIPPED()
+#define QLOG_INFO_EVERY_MS(ms)   QS_LOG_STRIPPED()
+#define QLOG_INFO_SAMPLED(rate)  QS_LOG_STRIPPED()
+#define QLOG_INFO_ONCE()         QS_LOG_STRIPPED()
+#define QLOG_CAT_INFO(category)    QS_LOG_STRIPPED()
+#else
+#define QLOG_INFO(...)   QS_LOG_STREAM(QsLogging::InfoLevel, __VA_ARGS__)
+#define QLOG_INFO_RAW()  QS_LOG_RAW_STREAM(QsLogging::InfoLevel)
+#define QLOG_INFOF(...)  QS_LOG_FORMAT_STREAM(QsLogging::InfoLevel, __VA_ARGS__)
+#define QLOG_INFO_EVERY_N(n)     QS_LOG_LIMITED_STREAM(QsLogging::InfoLevel, EveryNLimiter, n)
+#define QLOG_INFO_EVERY_MS(ms)   QS_LOG_LIMITED_STREAM(QsLogging::InfoLevel, IntervalLimiter, ms)
+#define QLOG_INFO_SAMPLED(rate)  QS_LOG_LIMITED_STREAM(QsLogging::InfoLevel, SampleLimiter, rate)
+#define QLOG_INFO_ONCE()         QS_LOG_LIMITED_STREAM(QsLogging::InfoLevel, OnceLimiter, 0)
+#define QLOG_CAT_INFO(category)    QS_LOG_CATEGORY_STREAM(category, QsLogging::InfoLevel)
+#endif
+
+#if QS_LOG_COMPILE_LEVEL > 3
+#define QLOG_WARN(...)   QS_LOG_STRIPPED()
+#define QLOG_WARN_RAW()  QS_LOG_STRIPPED()
+#define QLOG_WARNF(...)  QS_LOG_STRIPPED()
+#define QLOG_WARN_EVERY_N(n)     QS_LOG_STRIPPED()
+#define QLOG_WARN_EVERY_MS(ms)   QS_LOG_STRIPPED()
+#define QLOG_WARN_SAMPLED(rate)  QS_LOG_STRIPPED()
+#define QLOG_WARN_ONCE()         QS_LOG_STRIPPED()
+#define QLOG_CAT_WARN(category)    QS_LOG_STRIPPED()
+#else
+#define QLOG_WARN(...)   QS_LOG_STREAM(QsLogging::WarnLevel, __VA_ARGS__)
+#define QLOG_WARN_RAW()  QS_LOG_RAW_STREAM(QsLogging::WarnLevel)
+#define QLOG_WARNF(...)  QS_LOG_FORMAT_STREAM(QsLogging::WarnLevel, __VA_ARGS__)
+#define QLOG_WARN_EVERY_N(n)     QS_LOG_LIMITED_STREAM(QsLogging::WarnLevel, EveryNLimiter, n)
+#define QLOG_WARN_EVERY_MS(ms)   QS_LOG_LIMITED_STREAM(QsLogging::WarnLevel, IntervalLimiter, ms)
+#define QLOG_WARN_SAMPLED(rate)  QS_LOG_LIMITED_STREAM(QsLogging::WarnLevel, SampleLimiter, rate)
+#define QLOG_WARN_ONCE()         QS_LOG_LIMITED_STREAM(QsLogging::WarnLevel, OnceLimiter, 0)
+#define QLOG_CAT_WARN(category)    QS_LOG_CATEGORY_STREAM(category, QsLogging::WarnLevel)
+#endif
+
+#if QS_LOG_COMPILE_LEVEL > 4
+#define QLOG_ERROR(...)  QS_LOG_STRIPPED()
+#define QLOG_ERROR_RAW() QS_LOG_STRIPPED()
+#define QLOG_ERRORF(...) QS_LOG_STRIPPED()
+#define QLOG_ERROR_EVERY_N(n)     QS_LOG_STRIPPED()
+#define QLOG_ERROR_EVERY_MS(ms)   QS_LOG_STRIPPED()
+#define QLOG_ERROR_SAMPLED(rate)  QS_LOG_STRIPPED()
+#define QLOG_ERROR_ONCE()         QS_LOG_STRIPPED()
+#define QLOG_CAT_ERROR(category)    QS_LOG_STRIPPED()
+#else
+#define QLOG_ERROR(...)  QS_LOG_STREAM(QsLogging::ErrorLevel, __VA_ARGS__)
+#define QLOG_ERROR_RAW() QS_LOG_RAW_STREAM(QsLogging::ErrorLevel)
+#define QLOG_ERRORF(...) QS_LOG_FORMAT_STREAM(QsLogging::ErrorLevel, __VA_ARGS__)
+#define QLOG_ERROR_EVERY_N(n)     QS_LOG_LIMITED_STREAM(QsLogging::ErrorLevel, EveryNLimiter, n)
+#define QLOG_ERROR_EVERY_MS(ms)   QS_LOG_LIMITED_STREAM(QsLogging::ErrorLevel, IntervalLimiter, ms)
+#define QLOG_ERROR_SAMPLED(rate)  QS_LOG_LIMITED_STREAM(QsLogging::ErrorLevel, SampleLimiter, rate)
+#define QLOG_ERROR_ONCE()         QS_LOG_LIMITED_STREAM(QsLogging::ErrorLevel, OnceLimiter, 0)
+#define QLOG_CAT_ERROR(category)    QS_LOG_CATEGORY_STREAM(category, QsLogging::ErrorLevel)
+#endif
+
+#if QS_LOG_COMPILE_LEVEL > 5
+#define QLOG_FATAL(...)  QS_LOG_STRIPPED()
+#define QLOG_FATAL_RAW() QS_LOG_STRIPPED()
+#define QLOG_FATALF(...) QS_LOG_STRIPPED()
+#define QLOG_FATAL_EVERY_N(n)     QS_LOG_STRIPPED()
+#define QLOG_FATAL_EVERY_MS(ms)   QS_LOG_STRIPPED()
+#define QLOG_FATAL_SAMPLED(rate)  QS_LOG_STRIPPED()
+#define QLOG_FATAL_ONCE()         QS_LOG_STRIPPED()
+#define QLOG_CAT_FATAL(category)    QS_LOG_STRIPPED()
+#else
+#define QLOG_FATAL(...)  QS_LOG_STREAM(QsLogging::FatalLevel, __VA_ARGS__)
+#define QLOG_FATAL_RAW() QS_LOG_RAW_STREAM(QsLogging::FatalLevel)
+#define QLOG_FATALF(...) QS_LOG_FORMAT_STREAM(QsLogging::FatalLevel, __VA_ARGS__)
+#define QLOG_FATAL_EVERY_N(n)     QS_LOG_LIMITED_STREAM(QsLogging::FatalLevel, EveryNLimiter, n)
+#define QLOG_FATAL_EVERY_MS(ms)   QS_LOG_LIMITED_STREAM(QsLogging::FatalLevel, IntervalLimiter, ms)
+#define QLOG_FATAL_SAMPLED(rate)  QS_LOG_LIMITED_STREAM(QsLogging::FatalLevel, SampleLimiter, rate)
+#define QLOG_FATAL_ONCE()         QS_LOG_LIMITED_STREAM(QsLogging::FatalLevel, OnceLimiter, 0)
+#define QLOG_CAT_FATAL(category)    QS_LOG_CATEGORY_STREAM(category, QsLogging::FatalLevel)
+#endif
+
+#ifdef QS_LOG_DISABLE
+#include "QsLogDisableForThisFile.h"
+#endif
+
+#endif // QSLOG_H
@@ -0,0 +1,349 @@
+﻿#include "QsLogArguments.h"
+#include <cstring>
+
+namespace QsLogging
+{
+
+// 记录首字节的标志位
+static const char RecordRawFlag = 0x01;
+
+DeferredStream::DeferredStream(QByteArray* record, QString* scratchText, QDebug* scratchDebug) :
+    m_record(record),
+    m_scratchText(scratchText),
+    m_scratchDebug(scratchDebug),
+    m_space(true),
+    m_quote(true)
+{
+}
+
+void DeferredStream::begin(bool raw)
+{
+    m_space = !raw;
+    m_quote = !raw;
+    const char flags = raw ? RecordRawFlag : 0;
+    m_record->append(&flags, 1);
+}
+
+DeferredStream& DeferredStream::operator<<(const QDateTime& value)
+{
+    // 无效时间和基于时区对象的时间无法仅凭时间戳还原，退回立即格式化
+    if (!value.isValid() || value.timeSpec() == Qt::TimeZone) {
+        beginEager() << value;
+        endEager();
+        return *this;
+    }
+    putTag(ArgDateTime);
+    putValue(qint64(value.toMSecsSinceEpoch()));
+    putValue(qint8(value.timeSpec()));
+    putValue(qint32(value.offsetFromUtc()));
+    return *this;
+}
+
+QDebug& DeferredStream::beginEager()
+{
+    m_scratchText->resize(0);
+    m_scratchDebug->resetFormat();
+    // 记录中的文本由写入线程负责插入空格，这里只需保持引号状态一致
+    m_scratchDebug->nospace();
+    if (!m_quote) {
+        m_scratchDebug->noquote();
+    }
+    return *m_scratchDebug;
+}
+
+void DeferredStream::endEager()
+{
+    int end = m_scratchText->size();
+    // 自定义 operator<< 内部可能恢复了 space 状态并追加空格，这里去掉
+    while (end > 0 && m_scratchText->at(end - 1) == QLatin1Char(' ')) {
+        --end;
+    }
+    putTag(ArgPreformatted);
+    putBytes(reinterpret_cast<const char*>(m_scratchText->constData()), end * 2, end);
+    m_scratchText->resize(0);
+}
+
+// -- 记录解码 --
+namespace
+{
+
+// 按字节读取记录，不要求数据对齐。记录可能来自崩溃转储或持久化日志环等外部文件，
+// 每次读取都检查剩余的字节数，越界时置失败标志并返回空值，之后的读取都不再进行
+class RecordReader
+{
+public:
+    RecordReader(const QByteArray& record) :
+        m_pos(record.constData()),
+        m_end(record.constData() + record.size()),
+        m_failed(false)
+    {
+    }
+
+    bool atEnd() const { return m_failed || m_pos >= m_end; }
+    bool failed() const { return m_failed; }
+    // 遇到无法识别的内容时停止读取
+    void fail() { m_failed = true; }
+
+    template <typename T>
+    T read()
+    {
+        T value = T();
+        if (!take(sizeof(T))) {
+            return value;
+        }
+        std::memcpy(&value, m_pos - sizeof(T), sizeof(T));
+        return value;
+    }
+
+    QString readString()
+    {
+        const qint32 length = read<qint32>();
+        if (length < 0 || !take(size_t(length) * 2)) {
+            m_failed = true;
+            return QString();
+        }
+        QString value(length, Qt::Uninitialized);
+        std::memcpy(value.data(), m_pos - size_t(length) * 2, size_t(length) * 2);
+        return value;
+    }
+
+    QByteArray readBytes()
+    {
+        const qint32 length = read<qint32>();
+        if (length < 0 || !take(size_t(length))) {
+            m_failed = true;
+            return QByteArray();
+        }
+        return QByteArray(m_pos - length, length);
+    }
+
+private:
+    // 剩余字节足够时前进 size 字节并返回 true
+    bool take(size_t size)
+    {
+        if (m_failed || size_t(m_end - m_pos) < size) {
+            m_failed = true;
+            return false;
+        }
+        m_pos += size;
+        return true;
+    }
+
+    const char* m_pos;
+    const char* m_end;
+    bool m_failed;
+};
+
+} // end anonymous namespace
+
+QString DeferredStream::format(const QByteArray& record, bool replayTextStreamFunctions, bool* ok)
+{
+    QString text;
+    if (ok) {
+        *ok = true;
+    }
+    if (record.isEmpty()) {
+        return text;
+    }
+
+    RecordReader reader(record);
+    const bool raw = (reader.read<char>() & RecordRawFlag) != 0;
+    bool space = !raw;
+    bool quote = !raw;
+    {
+        QDebug debug(&text);
+        if (raw) {
+            debug.nospace().noquote();
+        }
+        while (!reader.atEnd()) {
+            switch (static_cast<ArgumentType>(reader.read<char>())) {
+            case ArgBool:
+                debug << (reader.read<quint8>() != 0);
+                break;
+            case ArgChar:
+                debug << reader.read<char>();
+                break;
+            case ArgQChar:
+                debug << QChar(reader.read<ushort>());
+                break;
+            case ArgInt32:
+                debug << reader.read<qint32>();
+                break;
+            case ArgUInt32:
+                debug << reader.read<quint32>();
+                break;
+            case ArgInt64:
+                debug << reader.read<qint64>();
+                break;
+            case ArgUInt64:
+                debug << reader.read<quint64>();
+                break;
+            case ArgDouble:
+                debug << reader.read<double>();
+                break;
+            case ArgCString:
+                debug << reader.readBytes().constData();
+                break;
+            case ArgString:
+                debug << reader.readString();
+                break;
+            case ArgByteArray:
+                debug << reader.readBytes();
+                break;
+            case ArgDateTime: {
+                const qint64 msecs = reader.read<qint64>();
+                const Qt::TimeSpec spec = static_cast<Qt::TimeSpec>(reader.read<qint8>());
+                const qint32 offset = reader.read<qint32>();
+                debug << QDateTime::fromMSecsSinceEpoch(msecs, spec, offset);
+                break;
+            }
+            case ArgPreformatted:
+                // 原样输出已格式化的文本，随后恢复格式状态并补上自动空格
+                debug.nospace().noquote() << reader.readString();
+                if (quote) {
+                    debug.quote();
+                }
+                if (space) {
+                    debug.space();
+                }
+                break;
+            case ArgTextStreamFunc: {
+                const QTextStreamFunction function = reader.read<QTextStreamFunction>();
+                if (replayTextStreamFunctions) {
+                    debug << function;
+                }
+                break;
+            }
+            case ArgSpace:
+                space = true;
+                debug.space();
+                break;
+            case ArgNoSpace:
+                space = false;
+                debug.nospace();
+                break;
+            case ArgMaybeSpace:
+                debug.maybeSpace();
+                break;
+            case ArgQuote:
+                quote = true;
+                debug.quote();
+                break;
+            case ArgNoQuote:
+                quote = false;
+                debug.noquote();
+                break;
+            default:
+                // 未知的标记（例如来自其他版本的记录）之后的内容无法解析
+                reader.fail();
+                break;
+            }
+        }
+    }
+    if (ok) {
+        *ok = !reader.failed();
+    }
+    return raw ? text : text.trimmed();
+}
+
+QVariantList DeferredStream::values(const QByteArray& record, bool* ok)
+{
+    QVariantList result;
+    if (ok) {
+        *ok = true;
+    }
+    if (record.isEmpty()) {
+        return result;
+    }
+
+    RecordReader reader(record);
+    reader.read<char>(); // 标志字节
+    while (!reader.atEnd()) {
+        const int count = result.size();
+        switch (static_cast<ArgumentType>(reader.read<char>())) {
+        case ArgBool:
+            result.append(reader.read<quint8>() != 0);
+            break;
+        case ArgChar:
+            result.append(QString(QChar::fromLatin1(reader.read<char>())));
+            break;
+        case ArgQChar:
+            result.append(QString(QChar(reader.read<ushort>())));
+            break;
+        case ArgInt32:
+            result.append(reader.read<qint32>());
+            break;
+        case ArgUInt32:
+            result.append(reader.read<quint32>());
+            break;
+        case ArgInt64:
+            result.append(reader.read<qint64>());
+            break;
+        case ArgUInt64:
+            result.append(reader.read<quint64>());
+            break;
+        case ArgDouble:
+            result.append(reader.read<double>());
+            break;
+        case ArgCString:
+            result.append(QString::fromUtf8(reader.readBytes()));
+            break;
+        case ArgString:
+        case ArgPreformatted:
+            result.append(reader.readString());
+            break;
+        case ArgByteArray:
+            result.append(reader.readBytes());
+            break;
+        case ArgDateTime: {
+            const qint64 msecs = reader.read<qint64>();
+            const Qt::TimeSpec spec = static_cast<Qt::TimeSpec>(reader.read<qint8>());
+            const qint32 offset = reader.read<qint32>();
+            result.append(QDateTime::fromMSecsSinceEpoch(msecs, spec, offset));
+            break;
+        }
+        case ArgTextStreamFunc:
+            reader.read<QTextStreamFunction>();
+            break;
+        case ArgSpace:
+        case ArgNoSpace:
+        case ArgMaybeSpace:
+        case ArgQuote:
+        case ArgNoQuote:
+            break;
+        default:
+            reader.fail();
+            break;
+        }
+        if (reader.failed()) {
+            // 读取中途失败时刚加入的值不完整
+            while (result.size() > count) {
+                result.removeLast();
+            }
+            if (ok) {
+                *ok = false;
+            }
+        }
+    }
+    return result;
+}
+
+bool StructuredStream::decode(const QByteArray& record, QString* message, LogFields* fields)
+{
+    bool ok = true;
+    const QVariantList values = DeferredStream::values(record, &ok);
+    if (values.isEmpty()) {
+        return ok;
+    }
+    *message = values.at(0).toString();
+    fields->reserve(values.size() / 2);
+    for (int i = 1; i + 1 < values.size(); i += 2) {
+        LogField field;
+        field.key = values.at(i).toString();
+        field.value = values.at(i + 1);
+        fields->append(field);
+    }
+    return ok;
+}
+
+} // end namespace
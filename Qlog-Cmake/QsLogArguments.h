@@ -0,0 +1,186 @@
+﻿#ifndef QSLOGARGUMENTS_H
+#define QSLOGARGUMENTS_H
+
+#include "QsLogDest.h"
+#include "QsLogField.h"
+#include <QByteArray>
+#include <QDateTime>
+#include <QDebug>
+#include <QString>
+#include <QVariant>
+#include <QtGlobal>
+#include <cstring>
+
+namespace QsLogging
+{
+
+// 延迟格式化记录中每个参数的类型标记
+enum ArgumentType
+{
+    ArgBool = 0,        // bool
+    ArgChar,            // char
+    ArgQChar,           // QChar
+    ArgInt32,           // short/int
+    ArgUInt32,          // unsigned short/unsigned int
+    ArgInt64,           // long/long long
+    ArgUInt64,          // unsigned long/unsigned long long
+    ArgDouble,          // float/double
+    ArgCString,         // const char*，按 UTF-8 拷贝
+    ArgString,          // QString，按 UTF-16 拷贝
+    ArgByteArray,       // QByteArray
+    ArgDateTime,        // QDateTime（毫秒时间戳、时间规范与偏移）
+    ArgPreformatted,    // 不支持延迟格式化的类型，已在调用线程格式化好的文本
+    ArgTextStreamFunc,  // QTextStream 操纵符，例如 hex/dec
+    ArgSpace,           // QDebug::space()
+    ArgNoSpace,         // QDebug::nospace()
+    ArgMaybeSpace,      // QDebug::maybeSpace()
+    ArgQuote,           // QDebug::quote()
+    ArgNoQuote          // QDebug::noquote()
+};
+
+// 延迟格式化流：在调用线程上只把参数的类型和取值追加到紧凑的二进制记录中，
+// 由日志写入线程调用 format() 还原为与 QDebug 输出一致的文本。
+// 不支持的类型会退回到调用线程上通过 QDebug 立即格式化，并以文本形式记录。
+// 记录格式：[标志字节][类型标记][取值]...，字符串以 32 位长度开头。
+class QSLOG_SHARED_OBJECT DeferredStream
+{
+public:
+    // 绑定记录缓冲区，以及立即格式化时使用的临时文本与 QDebug
+    DeferredStream(QByteArray* record, QString* scratchText, QDebug* scratchDebug);
+
+    // 开始一条新记录，raw 为 true 时不插入空格、不加引号，也不裁剪首尾空白
+    void begin(bool raw);
+
+    DeferredStream& operator<<(bool value) { putTag(ArgBool); putValue(quint8(value ? 1 : 0)); return *this; }
+    DeferredStream& operator<<(char value) { putTag(ArgChar); putValue(value); return *this; }
+    DeferredStream& operator<<(QChar value) { putTag(ArgQChar); putValue(value.unicode()); return *this; }
+    DeferredStream& operator<<(short value) { putTag(ArgInt32); putValue(qint32(value)); return *this; }
+    DeferredStream& operator<<(unsigned short value) { putTag(ArgUInt32); putValue(quint32(value)); return *this; }
+    DeferredStream& operator<<(int value) { putTag(ArgInt32); putValue(qint32(value)); return *this; }
+    DeferredStream& operator<<(unsigned int value) { putTag(ArgUInt32); putValue(quint32(value)); return *this; }
+    DeferredStream& operator<<(long value) { putTag(ArgInt64); putValue(qint64(value)); return *this; }
+    DeferredStream& operator<<(unsigned long value) { putTag(ArgUInt64); putValue(quint64(value)); return *this; }
+    DeferredStream& operator<<(long long value) { putTag(ArgInt64); putValue(qint64(value)); return *this; }
+    DeferredStream& operator<<(unsigned long long value) { putTag(ArgUInt64); putValue(quint64(value)); return *this; }
+    DeferredStream& operator<<(float value) { putTag(ArgDouble); putValue(double(value)); return *this; }
+    DeferredStream& operator<<(double value) { putTag(ArgDouble); putValue(value); return *this; }
+    DeferredStream& operator<<(const char* value)
+    {
+        putTag(ArgCString);
+        putBytes(value, value ? static_cast<int>(std::strlen(value)) : 0);
+        return *this;
+    }
+    DeferredStream& operator<<(const QString& value)
+    {
+        putTag(ArgString);
+        putBytes(reinterpret_cast<const char*>(value.constData()), value.size() * 2, value.size());
+        return *this;
+    }
+    DeferredStream& operator<<(const QByteArray& value)
+    {
+        putTag(ArgByteArray);
+        putBytes(value.constData(), value.size());
+        return *this;
+    }
+    DeferredStream& operator<<(const QDateTime& value);
+    DeferredStream& operator<<(QTextStreamFunction function)
+    {
+        putTag(ArgTextStreamFunc);
+        putValue(function);
+        return *this;
+    }
+
+    // 其他类型：在调用线程上立即格式化
+    template <typename T>
+    DeferredStream& operator<<(const T& value)
+    {
+        beginEager() << value;
+        endEager();
+        return *this;
+    }
+
+    // 与 QDebug 同名的格式控制函数，记录下来在写入线程上重放
+    DeferredStream& space() { m_space = true; putTag(ArgSpace); return *this; }
+    DeferredStream& nospace() { m_space = false; putTag(ArgNoSpace); return *this; }
+    DeferredStream& maybeSpace() { putTag(ArgMaybeSpace); return *this; }
+    DeferredStream& quote() { m_quote = true; putTag(ArgQuote); return *this; }
+    DeferredStream& noquote() { m_quote = false; putTag(ArgNoQuote); return *this; }
+
+    // 将一条记录还原为文本，在日志写入线程上调用
+    // replayTextStreamFunctions 为 false 时跳过记录中的流操作函数指针（如 hex、endl），
+    // 用于还原来自其他进程（例如崩溃转储）的记录，此时函数指针已经无效。
+    // 记录不完整、长度越界或含有未知的标记时在该处停止，ok 不为空时置为 false
+    static QString format(const QByteArray& record, bool replayTextStreamFunctions = true, bool* ok = nullptr);
+    // 将一条记录中的参数还原为各自类型的值，格式控制标记会被忽略；记录损坏时的处理同 format()
+    static QVariantList values(const QByteArray& record, bool* ok = nullptr);
+
+private:
+    void putTag(ArgumentType type)
+    {
+        const char tag = static_cast<char>(type);
+        m_record->append(&tag, 1);
+    }
+
+    template <typename T>
+    void putValue(const T& value)
+    {
+        m_record->append(reinterpret_cast<const char*>(&value), static_cast<int>(sizeof(T)));
+    }
+
+    // length 为元素个数（字符串为字符数），bytes 为实际拷贝的字节数
+    void putBytes(const char* data, int bytes, int length = -1)
+    {
+        putValue(qint32(length < 0 ? bytes : length));
+        if (bytes > 0) {
+            m_record->append(data, bytes);
+        }
+    }
+
+    // 准备临时 QDebug 并返回，立即格式化的结果由 endEager() 写入记录
+    QDebug& beginEager();
+    void endEager();
+
+    QByteArray* m_record;   // 当前记录
+    QString* m_scratchText; // 立即格式化使用的临时文本
+    QDebug* m_scratchDebug; // 写入 m_scratchText 的 QDebug
+    bool m_space;           // 当前是否自动插入空格
+    bool m_quote;           // 当前是否给字符串加引号
+};
+
+// 结构化日志流：消息文本与 kv() 添加的字段以类型化的值写入紧凑记录，
+// 调用线程不做任何格式化，由写入线程通过 decode() 还原为消息文本和 LogField。
+// 记录格式与 DeferredStream 相同：消息之后依次是字段名和字段值。
+class QSLOG_SHARED_OBJECT StructuredStream
+{
+public:
+    StructuredStream(QByteArray* record, QString* scratchText, QDebug* scratchDebug) :
+        m_values(record, scratchText, scratchDebug)
+    {
+    }
+
+    // 开始一条新记录并写入消息文本
+    template <typename T>
+    void begin(const T& message)
+    {
+        m_values.begin(true);
+        m_values << message;
+    }
+
+    // 添加一个字段，字段名通常为字符串字面量
+    template <typename T>
+    StructuredStream& kv(const char* key, const T& value)
+    {
+        m_values << key << value;
+        return *this;
+    }
+
+    // 将记录还原为消息文本和字段列表，在日志写入线程上调用；记录损坏时返回 false，结果只含损坏之前的部分
+    static bool decode(const QByteArray& record, QString* message, LogFields* fields);
+
+private:
+    DeferredStream m_values;
+};
+
+} // end namespace QsLogging
+
+#endif // QSLOGARGUMENTS_H
@@ -0,0 +1,42 @@
+﻿#include "QsLogClock.h"
+
+namespace QsLogging
+{
+
+namespace
+{
+
+// 单调时钟与系统时间的对应关系，进程内只采样一次
+struct ClockAnchor
+{
+    ClockAnchor() :
+        monotonic(Clock::now()),
+        epoch(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::system_clock::now().time_since_epoch()).count())
+    {
+    }
+
+    qint64 monotonic; // 采样时的单调时钟读数
+    qint64 epoch;     // 采样时自纪元起的纳秒数
+};
+
+const ClockAnchor& clockAnchor()
+{
+    static const ClockAnchor anchor;
+    return anchor;
+}
+
+} // end anonymous namespace
+
+qint64 Clock::toEpochNanoseconds(qint64 timestamp)
+{
+    const ClockAnchor& anchor = clockAnchor();
+    return anchor.epoch + (timestamp - anchor.monotonic);
+}
+
+QDateTime Clock::toDateTime(qint64 timestamp)
+{
+    return QDateTime::fromMSecsSinceEpoch(toEpochNanoseconds(timestamp) / 1000000);
+}
+
+} // end namespace
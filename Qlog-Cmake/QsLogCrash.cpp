@@ -0,0 +1,465 @@
+﻿#include "QsLogCrash.h"
+#include "QsLogClock.h"
+#include "QsLogDestFile.h"
+#include "QsLogRecordEncoder.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <atomic>
+#include <cstring>
+#include <signal.h>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace QsLogging
+{
+
+// -- 转储文件格式（本机字节序） --
+// 文件头之后逐条存放记录（编码见 QsLogRecordEncoder.h）。安装时写入状态为 Armed 的文件头，其余部分预分配为 0；
+// 崩溃处理函数写完记录后把状态改为 Dumped 并填写记录数。
+// 读取时按记录头的魔数逐条读取，即使崩溃处理函数未能写完，已写出的完整记录也能恢复。
+static const char CrashDumpMagic[8] = {'Q', 'S', 'L', 'O', 'G', 'C', 'R', 'S'};
+static const quint32 CrashDumpVersion = 1;
+enum CrashDumpState
+{
+    CrashDumpArmed = 0,  // 已安装，尚未发生崩溃
+    CrashDumpDumped = 1  // 崩溃处理函数已写完所有记录
+};
+
+struct CrashDumpHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 state;   // CrashDumpState
+    qint32 signal;   // 触发转储的信号（Windows 上为异常代码）
+    quint32 count;   // 写出的记录数
+    char reserved[40];
+};
+
+// 转储来源的登记上限：Logger 占一个，其余留给异步目标
+static const int MaxCrashDumpSources = 32;
+// 崩溃处理函数使用的写出缓冲区大小
+static const size_t CrashDumpBufferSize = 64 * 1024;
+// 崩溃处理函数使用的备用信号栈大小，栈溢出时仍能运行处理函数
+static const size_t CrashAltStackSize = 64 * 1024;
+
+struct CrashSourceSlot
+{
+    std::atomic<CrashDumpSource> source;
+    std::atomic<void*> context;
+};
+
+// 崩溃处理函数只读取以下静态数据，不再进行任何分配
+static CrashSourceSlot s_sources[MaxCrashDumpSources];
+static QMutex s_sourcesMutex;             // 保护来源的登记与注销
+static QMutex s_installMutex;             // 保护安装与卸载
+static std::atomic<qintptr> s_dumpHandle(-1); // 转储文件，-1 表示未安装
+static qint64 s_epochOffset = 0;          // 单调时钟读数换算为纪元纳秒的偏移，安装时确定
+static std::atomic_flag s_dumping = ATOMIC_FLAG_INIT; // 防止处理函数重入（例如转储过程中再次崩溃）
+static char s_dumpBuffer[CrashDumpBufferSize];
+
+// -- 文件操作，崩溃处理函数只使用其中的 writeAll/seekTo/syncFile --
+#if defined(Q_OS_WIN)
+
+static qintptr openDumpFile(const QString& path, qint64 size)
+{
+    HANDLE file = CreateFileW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(path).utf16()),
+                              GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return -1;
+    }
+    LARGE_INTEGER end;
+    end.QuadPart = size;
+    // 设置文件末尾即分配磁盘空间，崩溃时不必再扩展文件
+    if (!SetFilePointerEx(file, end, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+        CloseHandle(file);
+        return -1;
+    }
+    return reinterpret_cast<qintptr>(file);
+}
+
+static void closeDumpFile(qintptr handle)
+{
+    CloseHandle(reinterpret_cast<HANDLE>(handle));
+}
+
+static void writeAll(qintptr handle, const void* data, size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        DWORD written = 0;
+        const DWORD chunk = size > 0x40000000 ? 0x40000000 : static_cast<DWORD>(size);
+        if (!WriteFile(reinterpret_cast<HANDLE>(handle), bytes, chunk, &written, nullptr) || written == 0) {
+            return;
+        }
+        bytes += written;
+        size -= written;
+    }
+}
+
+static void seekTo(qintptr handle, qint64 offset)
+{
+    LARGE_INTEGER position;
+    position.QuadPart = offset;
+    SetFilePointerEx(reinterpret_cast<HANDLE>(handle), position, nullptr, FILE_BEGIN);
+}
+
+static void syncFile(qintptr handle)
+{
+    FlushFileBuffers(reinterpret_cast<HANDLE>(handle));
+}
+
+#else
+
+static qintptr openDumpFile(const QString& path, qint64 size)
+{
+    const QByteArray nativePath = QFile::encodeName(path);
+    const int fd = ::open(nativePath.constData(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    // 预先分配磁盘空间，崩溃时只需覆盖写入；文件系统不支持时退回到设置文件大小
+#if defined(Q_OS_LINUX)
+    const bool reserved = ::posix_fallocate(fd, 0, size) == 0 || ::ftruncate(fd, size) == 0;
+#else
+    const bool reserved = ::ftruncate(fd, size) == 0;
+#endif
+    if (!reserved) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void closeDumpFile(qintptr handle)
+{
+    ::close(static_cast<int>(handle));
+}
+
+static void writeAll(qintptr handle, const void* data, size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t written = ::write(static_cast<int>(handle), bytes, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+static void seekTo(qintptr handle, qint64 offset)
+{
+    ::lseek(static_cast<int>(handle), static_cast<off_t>(offset), SEEK_SET);
+}
+
+static void syncFile(qintptr handle)
+{
+    ::fsync(static_cast<int>(handle));
+}
+
+#endif
+
+static void fillHeader(CrashDumpHeader& header, CrashDumpState state, int signal, quint32 count)
+{
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CrashDumpMagic, sizeof(header.magic));
+    header.version = CrashDumpVersion;
+    header.state = state;
+    header.signal = signal;
+    header.count = count;
+}
+
+// -- 信号与异常处理 --
+// 处理函数只写出记录，随后交还给原来的处理方式，由其产生核心转储或结束进程
+struct CrashSignalDispatcher
+{
+    static void handleSignal(int signal);
+#if defined(Q_OS_WIN)
+    static LONG WINAPI handleException(EXCEPTION_POINTERS* info);
+#endif
+};
+
+#if defined(Q_OS_WIN)
+
+typedef void (*SignalHandlerFunction)(int);
+static LPTOP_LEVEL_EXCEPTION_FILTER s_previousFilter = nullptr;
+static SignalHandlerFunction s_previousAbortHandler = SIG_DFL;
+
+void CrashSignalDispatcher::handleSignal(int signal)
+{
+    if (!s_dumping.test_and_set()) {
+        CrashHandler::dump(signal);
+    }
+    ::signal(SIGABRT, s_previousAbortHandler);
+    ::raise(signal);
+}
+
+LONG WINAPI CrashSignalDispatcher::handleException(EXCEPTION_POINTERS* info)
+{
+    if (!s_dumping.test_and_set()) {
+        CrashHandler::dump(static_cast<int>(info->ExceptionRecord->ExceptionCode));
+    }
+    return s_previousFilter ? s_previousFilter(info) : EXCEPTION_CONTINUE_SEARCH;
+}
+
+static void installCrashHandlers()
+{
+    s_previousFilter = SetUnhandledExceptionFilter(&CrashSignalDispatcher::handleException);
+    s_previousAbortHandler = ::signal(SIGABRT, &CrashSignalDispatcher::handleSignal);
+}
+
+static void restoreCrashHandlers()
+{
+    SetUnhandledExceptionFilter(s_previousFilter);
+    ::signal(SIGABRT, s_previousAbortHandler);
+}
+
+#else
+
+static const int CrashSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+static const int CrashSignalCount = sizeof(CrashSignals) / sizeof(CrashSignals[0]);
+static struct sigaction s_previousActions[CrashSignalCount];
+// 备用信号栈只对调用 install() 的线程生效，分配后不再释放，避免卸载时仍有处理函数在其上运行
+static char* s_altStack = nullptr;
+
+void CrashSignalDispatcher::handleSignal(int signal)
+{
+    if (!s_dumping.test_and_set()) {
+        CrashHandler::dump(signal);
+    }
+    // 恢复原来的处理方式后重新触发：信号在处理函数返回后才会递送，
+    // 由硬件异常触发的信号也会在返回后重新执行出错的指令而再次触发
+    for (int i = 0; i < CrashSignalCount; ++i) {
+        if (CrashSignals[i] == signal) {
+            ::sigaction(signal, &s_previousActions[i], nullptr);
+        }
+    }
+    ::raise(signal);
+}
+
+static void installCrashHandlers()
+{
+    if (!s_altStack) {
+        s_altStack = new char[CrashAltStackSize];
+        stack_t stack;
+        stack.ss_sp = s_altStack;
+        stack.ss_size = CrashAltStackSize;
+        stack.ss_flags = 0;
+        ::sigaltstack(&stack, nullptr);
+    }
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = &CrashSignalDispatcher::handleSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_ONSTACK;
+    for (int i = 0; i < CrashSignalCount; ++i) {
+        ::sigaction(CrashSignals[i], &action, &s_previousActions[i]);
+    }
+}
+
+static void restoreCrashHandlers()
+{
+    for (int i = 0; i < CrashSignalCount; ++i) {
+        ::sigaction(CrashSignals[i], &s_previousActions[i], nullptr);
+    }
+}
+
+#endif
+
+// -- CrashDumpWriter 实现 --
+CrashDumpWriter::CrashDumpWriter(qintptr handle) :
+    m_handle(handle),
+    m_used(0),
+    m_count(0)
+{
+}
+
+void CrashDumpWriter::write(const LogRecord& record)
+{
+    const RecordEncoder encoder(record, s_epochOffset);
+    auto sink = [this](const void* data, size_t size) { append(data, size); };
+    encoder.writeTo(sink);
+    ++m_count;
+}
+
+void CrashDumpWriter::append(const void* data, size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const size_t chunk = qMin(size, CrashDumpBufferSize - m_used);
+        std::memcpy(s_dumpBuffer + m_used, bytes, chunk);
+        m_used += chunk;
+        bytes += chunk;
+        size -= chunk;
+        if (m_used == CrashDumpBufferSize) {
+            flush();
+        }
+    }
+}
+
+void CrashDumpWriter::flush()
+{
+    writeAll(m_handle, s_dumpBuffer, m_used);
+    m_used = 0;
+}
+
+// -- CrashHandler 实现 --
+// 卸载，调用时持有 s_installMutex
+static void uninstallLocked()
+{
+    const qintptr handle = s_dumpHandle.exchange(-1);
+    if (handle == -1) {
+        return;
+    }
+    restoreCrashHandlers();
+    closeDumpFile(handle);
+}
+
+bool CrashHandler::install(const QString& dumpFilePath, qint64 reservedBytes)
+{
+    QMutexLocker locker(&s_installMutex);
+    uninstallLocked();
+    // 换算偏移在安装时确定，崩溃处理函数中不再调用 Clock
+    s_epochOffset = Clock::toEpochNanoseconds(0);
+    const qintptr handle = openDumpFile(dumpFilePath, qint64(sizeof(CrashDumpHeader)) + qMax<qint64>(reservedBytes, 0));
+    if (handle == -1) {
+        qWarning() << "QsLog: Failed to create crash dump file" << dumpFilePath;
+        return false;
+    }
+    CrashDumpHeader header;
+    fillHeader(header, CrashDumpArmed, 0, 0);
+    writeAll(handle, &header, sizeof(header));
+    syncFile(handle);
+    s_dumpHandle.store(handle);
+    installCrashHandlers();
+    return true;
+}
+
+void CrashHandler::uninstall()
+{
+    QMutexLocker locker(&s_installMutex);
+    uninstallLocked();
+}
+
+bool CrashHandler::isInstalled()
+{
+    return s_dumpHandle.load() != -1;
+}
+
+void CrashHandler::dump(int signal)
+{
+    const qintptr handle = s_dumpHandle.load();
+    if (handle == -1) {
+        return;
+    }
+    seekTo(handle, sizeof(CrashDumpHeader));
+    CrashDumpWriter writer(handle);
+    for (CrashSourceSlot& slot : s_sources) {
+        const CrashDumpSource source = slot.source.load(std::memory_order_acquire);
+        if (source) {
+            source(writer, slot.context.load(std::memory_order_relaxed));
+        }
+    }
+    writer.flush();
+    // 记录写完后才更新文件头
+    CrashDumpHeader header;
+    fillHeader(header, CrashDumpDumped, signal, writer.count());
+    seekTo(handle, 0);
+    writeAll(handle, &header, sizeof(header));
+    syncFile(handle);
+}
+
+bool CrashHandler::addSource(CrashDumpSource source, void* context)
+{
+    QMutexLocker locker(&s_sourcesMutex);
+    CrashSourceSlot* freeSlot = nullptr;
+    for (CrashSourceSlot& slot : s_sources) {
+        const CrashDumpSource current = slot.source.load(std::memory_order_relaxed);
+        if (current == source && slot.context.load(std::memory_order_relaxed) == context) {
+            return true;
+        }
+        if (!current && !freeSlot) {
+            freeSlot = &slot;
+        }
+    }
+    if (!freeSlot) {
+        return false;
+    }
+    // 先写上下文再发布函数，处理函数读到函数时上下文已经就绪
+    freeSlot->context.store(context, std::memory_order_relaxed);
+    freeSlot->source.store(source, std::memory_order_release);
+    return true;
+}
+
+void CrashHandler::removeSource(CrashDumpSource source, void* context)
+{
+    QMutexLocker locker(&s_sourcesMutex);
+    for (CrashSourceSlot& slot : s_sources) {
+        if (slot.source.load(std::memory_order_relaxed) == source
+            && slot.context.load(std::memory_order_relaxed) == context) {
+            slot.source.store(nullptr, std::memory_order_release);
+            slot.context.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+}
+
+QVector<RecoveredRecord> CrashHandler::readDump(const QString& dumpFilePath)
+{
+    QVector<RecoveredRecord> records;
+    QFile file(dumpFilePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return records;
+    }
+    const QByteArray content = file.readAll();
+    CrashDumpHeader header;
+    if (size_t(content.size()) < sizeof(header)) {
+        return records;
+    }
+    std::memcpy(&header, content.constData(), sizeof(header));
+    if (std::memcmp(header.magic, CrashDumpMagic, sizeof(header.magic)) != 0
+        || header.version != CrashDumpVersion) {
+        return records;
+    }
+
+    // 不依赖文件头中的记录数：逐条读取，直到遇到预分配的空白区域或不完整的记录
+    size_t offset = sizeof(header);
+    RecoveredRecord record;
+    while (const size_t size = RecordEncoder::decode(content.constData() + offset, content.size() - offset, record)) {
+        records.append(record);
+        offset += size;
+    }
+    return records;
+}
+
+int CrashHandler::mergeIntoDatabase(const QString& dumpFilePath, DatabaseDestination& database)
+{
+    if (!database.isValid()) {
+        return -1;
+    }
+    if (!QFile::exists(dumpFilePath)) {
+        return 0;
+    }
+    const QVector<RecoveredRecord> records = readDump(dumpFilePath);
+    const int merged = records.isEmpty() ? 0 : database.importRecords(records);
+    if (merged < 0) {
+        // 保留转储文件，下次启动时重试
+        return -1;
+    }
+    QFile::remove(dumpFilePath);
+    return merged;
+}
+
+} // end namespace QsLogging
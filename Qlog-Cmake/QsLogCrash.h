@@ -0,0 +1,82 @@
+﻿#ifndef QSLOGCRASH_H
+#define QSLOGCRASH_H
+
+#include "QsLogLevel.h"
+#include "QsLogDest.h"
+#include "QsLogRecord.h"
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <cstddef>
+
+namespace QsLogging
+{
+class CrashDumpWriter;
+class DatabaseDestination;
+
+// 崩溃时转储记录的来源，由 Logger 与异步目标登记，在崩溃处理函数中依次调用
+typedef void (*CrashDumpSource)(CrashDumpWriter& writer, void* context);
+
+// 在崩溃处理函数中把记录写入转储文件。不加锁、不分配内存，只调用 write() 等异步信号安全的系统调用，
+// 记录只被读取：尚未还原的延迟格式化与结构化内容按原始字节写出，读取转储时再还原
+class QSLOG_SHARED_OBJECT CrashDumpWriter
+{
+public:
+    // 写出一条记录
+    void write(const LogRecord& record);
+    // 已写出的记录数
+    quint32 count() const { return m_count; }
+
+private:
+    friend class CrashHandler;
+
+    explicit CrashDumpWriter(qintptr handle);
+    // 追加到缓冲区，缓冲区满时写出到文件
+    void append(const void* data, size_t size);
+    // 把缓冲区中的数据写出到文件
+    void flush();
+
+    qintptr m_handle; // 转储文件的描述符（Windows 上为 HANDLE）
+    size_t m_used;    // 缓冲区中尚未写出的字节数
+    quint32 m_count;
+};
+
+// 进程崩溃时的紧急转储：安装后，进程收到 SIGSEGV、SIGBUS、SIGFPE、SIGILL、SIGABRT
+// （Windows 上为未处理的结构化异常与 SIGABRT）时，把所有尚未持久化的记录
+// ——各线程缓冲区、共享回退队列、写入线程手中的批次以及异步目标队列中的记录——
+// 用原始的 write() 写入安装时预先分配好的转储文件，随后恢复原来的处理方式并重新触发信号。
+// 下次启动时调用 mergeIntoDatabase() 把转储的记录补写进日志数据库。
+// 转储是尽力而为的：崩溃时其他线程可能正在修改队列，个别记录可能缺失或与已写入数据库的记录重复，
+// 合并时按序号与时间戳跳过数据库中已有的记录。
+class QSLOG_SHARED_OBJECT CrashHandler
+{
+public:
+    // 预分配的转储文件默认大小，超出时文件照常增长
+    static const qint64 DefaultReservedBytes = 4 * 1024 * 1024;
+
+    // 创建并预分配转储文件，安装崩溃处理函数；已安装时先卸载。失败时返回 false
+    static bool install(const QString& dumpFilePath, qint64 reservedBytes = DefaultReservedBytes);
+    // 恢复原来的信号处理方式并关闭转储文件，文件本身保留
+    static void uninstall();
+    static bool isInstalled();
+
+    // 读取转储文件中的记录；文件不存在或没有发生过崩溃时返回空列表
+    static QVector<RecoveredRecord> readDump(const QString& dumpFilePath);
+    // 把转储文件中的记录写入数据库并删除转储文件，返回写入的条数，数据库不可用时返回 -1。
+    // 应在 install() 之前、数据库目标开始接收新日志之前调用
+    static int mergeIntoDatabase(const QString& dumpFilePath, DatabaseDestination& database);
+
+    // 登记与注销转储来源，相同的 source 与 context 只登记一次；来源数量有上限，登记失败时返回 false
+    static bool addSource(CrashDumpSource source, void* context);
+    static void removeSource(CrashDumpSource source, void* context);
+
+private:
+    friend struct CrashSignalDispatcher;
+
+    // 在崩溃处理函数中调用：写出所有来源的记录并更新文件头
+    static void dump(int signal);
+};
+
+} // end namespace QsLogging
+
+#endif // QSLOGCRASH_H
@@ -1,51 +1,106 @@
-﻿#include "QsLogDest.h"
-#include "QsLogDestConsole.h"
-#include "QsLogDestFile.h"
-#include "QsLogDestFunctor.h"
-#include <QString>
-#include <QScopedPointer>
-#include <QtGlobal>
-
-namespace QsLogging
-{
-// 使用虚函数确保子类的析构函数也会被调用
-Destination::~Destination() {}
-
-// 目的地工厂类，负责创建不同类型的日志目的地
-DestinationPtr DestinationFactory::MakeFileDestination(const QString& filePath,
-    LogRotationOption rotation, const MaxLogLines &linesToRotateAfter,
-    const MaxOldLogCount &oldLogsToKeep)
-{
-//    // 用于处理日志文件轮转。
-//    if (EnableLogRotation == rotation) {
-//        // 创建一个基于行数的日志轮转策略
-//        QScopedPointer<LineRotationStrategy> logRotation(new LineRotationStrategy);
-//        // 设置最大行数
-//        logRotation->setMaximumLines(linesToRotateAfter.lines);
-//        // 设置要保留的旧日志文件数量
-//        logRotation->setBackupCount(oldLogsToKeep.count);
-//        // 创建并返回带有行数轮转策略的文件目的地
-//        return DestinationPtr(new FileDestination(filePath, RotationStrategyPtr(logRotation.take())));
-//    }
-//    // 创建并返回带有空（不轮转）策略的文件目的地
-//    return DestinationPtr(new FileDestination(filePath, RotationStrategyPtr(new NullRotationStrategy)));
-}
-
-// 创建一个将日志输出到调试控制台的目的地
-DestinationPtr DestinationFactory::MakeDebugOutputDestination()
-{
-    return DestinationPtr(new DebugOutputDestination);
-}
-
-// 创建一个以函数作为回调的目的地
-DestinationPtr DestinationFactory::MakeFunctorDestination(QsLogging::Destination::LogFunction f)
-{
-    return DestinationPtr(new FunctorDestination(f));
-}
-
-// 创建一个以 Qt 信号-槽作为回调的目的地
-DestinationPtr DestinationFactory::MakeFunctorDestination(QObject *receiver, const char *member)
-{
-    return DestinationPtr(new FunctorDestination(receiver, member));
-}
-} // end namespace
+﻿#include "QsLogDest.h"
+#include "QsLogDestAsync.h"
+#include "QsLogDestConsole.h"
+#include "QsLogDestFile.h"
+#include "QsLogDestFunctor.h"
+#include "QsLogRecord.h"
+#include "QsLogSite.h"
+#include <QString>
+#include <QScopedPointer>
+#include <QtGlobal>
+
+namespace QsLogging
+{
+// 使用虚函数确保子类的析构函数也会被调用
+Destination::~Destination() {}
+
+// 默认按调用点信息在消息前加上 "文件@行号" 和 "[类别]"，在消息后加上 "键=值" 形式的字段
+void Destination::writeRecord(const LogRecord& record)
+{
+    const LogSite* site = record.site();
+    const QString& message = record.message();
+    const Level level = record.level();
+    const LogFields& fields = record.fields();
+    const bool decorated = site && ((site->flags & LogSite::ShowLocation) || site->category);
+    if (!decorated && fields.isEmpty()) {
+        write(message, level);
+        return;
+    }
+    QString text;
+    if (site && (site->flags & LogSite::ShowLocation)) {
+        text += QString::fromUtf8(site->file) + QLatin1Char('@') + QString::number(site->line) + QLatin1Char(' ');
+    }
+    if (site && site->category) {
+        text += QLatin1Char('[');
+        text += QString::fromUtf8(site->category);
+        text += QLatin1String("] ");
+    }
+    text += message;
+    for (const LogField& field : fields) {
+        text += QLatin1Char(' ');
+        text += field.key;
+        text += QLatin1Char('=');
+        text += field.value.toString();
+    }
+    write(text, level);
+}
+
+// 默认逐条写入
+void Destination::writeBatch(const LogRecordList& records)
+{
+    for (const LogRecordPtr& record : records) {
+        writeRecord(*record);
+    }
+}
+
+// 默认没有需要持久化的缓冲
+bool Destination::sync()
+{
+    return true;
+}
+
+// 目的地工厂类，负责创建不同类型的日志目的地
+DestinationPtr DestinationFactory::MakeFileDestination(const QString& filePath,
+    LogRotationOption rotation, const MaxLogLines &linesToRotateAfter,
+    const MaxOldLogCount &oldLogsToKeep)
+{
+//    // 用于处理日志文件轮转。
+//    if (EnableLogRotation == rotation) {
+//        // 创建一个基于行数的日志轮转策略
+//        QScopedPointer<LineRotationStrategy> logRotation(new LineRotationStrategy);
+//        // 设置最大行数
+//        logRotation->setMaximumLines(linesToRotateAfter.lines);
+//        // 设置要保留的旧日志文件数量
+//        logRotation->setBackupCount(oldLogsToKeep.count);
+//        // 创建并返回带有行数轮转策略的文件目的地
+//        return DestinationPtr(new FileDestination(filePath, RotationStrategyPtr(logRotation.take())));
+//    }
+//    // 创建并返回带有空（不轮转）策略的文件目的地
+//    return DestinationPtr(new FileDestination(filePath, RotationStrategyPtr(new NullRotationStrategy)));
+}
+
+// 创建一个将日志输出到调试控制台的目的地
+DestinationPtr DestinationFactory::MakeDebugOutputDestination()
+{
+    return DestinationPtr(new DebugOutputDestination);
+}
+
+// 创建一个以函数作为回调的目的地
+DestinationPtr DestinationFactory::MakeFunctorDestination(QsLogging::Destination::LogFunction f)
+{
+    return DestinationPtr(new FunctorDestination(f));
+}
+
+// 创建一个以 Qt 信号-槽作为回调的目的地
+DestinationPtr DestinationFactory::MakeFunctorDestination(QObject *receiver, const char *member)
+{
+    return DestinationPtr(new FunctorDestination(receiver, member));
+}
+
+// 创建一个在独立线程上写入的目的地
+DestinationPtr DestinationFactory::MakeAsyncDestination(const DestinationPtr& destination, int queueCapacity,
+                                                        bool blockWhenFull)
+{
+    return DestinationPtr(new AsyncDestination(destination, queueCapacity, blockWhenFull));
+}
+} // end namespace
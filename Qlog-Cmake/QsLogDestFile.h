@@ -2,9 +2,12 @@
 #define QSLOGDESTFILE_H
 
 #include "QsLogDest.h"
+#include "QsLogRecord.h"
+#include <QHash>
 #include <QSharedPointer>
 #include <QSqlDatabase>
 #include <QSqlQuery>
+#include <QVector>
 
 namespace QsLogging
 {
@@ -21,16 +24,46 @@ public:
 
     // 实现基类的 write 纯虚函数，将日志消息写入数据库
     void write(const QString& message, Level level) override;
+    // 只存储消息的动态部分和调用点编号，调用点的静态信息单独保存在 log_sites 表中；
+    // 时间使用调用点记录的时间戳，而不是写入数据库的时间；线程标识和名称存入 thread_id/thread_name 列，序号存入 sequence 列；
+    // 结构化字段按原始类型存入 log_fields 表
+    void writeRecord(const LogRecord& record) override;
+    // 一批记录在同一个事务中写入
+    void writeBatch(const LogRecordList& records) override;
     // 实现基类的 isValid 纯虚函数，检查数据库连接是否有效
     bool isValid() override;
+    // 每批记录都已在各自的事务中提交，SQLite 提交即落盘，这里只报告数据库是否可用
+    bool sync() override;
+
+    // 导入不是由本进程写出的记录（崩溃转储或持久化日志环中恢复的记录），全部在一个事务中写入。
+    // 序号与时间戳都相同的记录已经存在时跳过；返回写入的条数，失败时返回 -1
+    int importRecords(const QVector<RecoveredRecord>& records);
 
 private:
     QSqlDatabase m_db;      // 数据库连接对象
     bool m_isDbValid;       // 标记数据库连接是否有效
     QSqlQuery m_query;      // 用于优化插入操作的预处理查询
+    QSqlQuery m_siteInsertQuery; // 登记调用点的预处理查询
+    QSqlQuery m_siteSelectQuery; // 查询调用点行号的预处理查询
+    QSqlQuery m_fieldInsertQuery; // 插入结构化字段的预处理查询
+    QSqlQuery m_entrySelectQuery; // 导入时按序号与时间戳查找已有记录的预处理查询
+    QHash<quint32, qint64> m_siteRows; // 进程内调用点编号到 log_sites 行号的缓存
 
     // 初始化数据库连接并创建表的私有方法
     void initDatabase(const QString& dbFilePath);
+    // 为旧版本数据库中的表补充缺少的列
+    bool ensureColumn(const QString& table, const QString& column, const QString& definition);
+    // 获取调用点在 log_sites 表中的行号，首次使用时写入该表；失败时返回 -1
+    qint64 siteRow(const LogSite* site);
+    // 按调用点的文本信息获取行号，不存在时写入该表；失败时返回 -1
+    qint64 siteRow(const QString& file, int line, const QString& function, Level level,
+                   const QVariant& format, const QVariant& category);
+    // 在单独的事务中插入一条日志记录
+    void writeEntry(const QString& message, Level level, qint64 siteRow, const LogMetadata& metadata,
+                    const LogFields& fields);
+    // 在当前事务中插入一条日志记录及其字段，siteRow 小于 0 表示没有调用点信息；失败时返回 false
+    bool insertEntry(const QString& message, Level level, qint64 siteRow, const LogMetadata& metadata,
+                     const LogFields& fields);
 };
 
 // DatabaseDestination 智能指针类型定义
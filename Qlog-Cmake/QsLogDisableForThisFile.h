@@ -2,6 +2,7 @@
 #define QSLOGDISABLEFORTHISFILE_H
 
 #include <QtDebug>
+#include "QsLog.h"
 
 // 首先取消定义所有日志宏，以防止重复定义警告
 #undef QLOG_TRACE
@@ -10,16 +11,99 @@
 #undef QLOG_WARN
 #undef QLOG_ERROR
 #undef QLOG_FATAL
+#undef QLOG_TRACE_RAW
+#undef QLOG_DEBUG_RAW
+#undef QLOG_INFO_RAW
+#undef QLOG_WARN_RAW
+#undef QLOG_ERROR_RAW
+#undef QLOG_FATAL_RAW
+#undef QLOG_TRACEF
+#undef QLOG_DEBUGF
+#undef QLOG_INFOF
+#undef QLOG_WARNF
+#undef QLOG_ERRORF
+#undef QLOG_FATALF
+#undef QLOG_TRACE_EVERY_N
+#undef QLOG_TRACE_EVERY_MS
+#undef QLOG_TRACE_SAMPLED
+#undef QLOG_TRACE_ONCE
+#undef QLOG_DEBUG_EVERY_N
+#undef QLOG_DEBUG_EVERY_MS
+#undef QLOG_DEBUG_SAMPLED
+#undef QLOG_DEBUG_ONCE
+#undef QLOG_INFO_EVERY_N
+#undef QLOG_INFO_EVERY_MS
+#undef QLOG_INFO_SAMPLED
+#undef QLOG_INFO_ONCE
+#undef QLOG_WARN_EVERY_N
+#undef QLOG_WARN_EVERY_MS
+#undef QLOG_WARN_SAMPLED
+#undef QLOG_WARN_ONCE
+#undef QLOG_ERROR_EVERY_N
+#undef QLOG_ERROR_EVERY_MS
+#undef QLOG_ERROR_SAMPLED
+#undef QLOG_ERROR_ONCE
+#undef QLOG_FATAL_EVERY_N
+#undef QLOG_FATAL_EVERY_MS
+#undef QLOG_FATAL_SAMPLED
+#undef QLOG_FATAL_ONCE
+#undef QLOG_CAT_TRACE
+#undef QLOG_CAT_DEBUG
+#undef QLOG_CAT_INFO
+#undef QLOG_CAT_WARN
+#undef QLOG_CAT_ERROR
+#undef QLOG_CAT_FATAL
 
 // 重新定义所有日志宏为空操作
-// QLOG_TRACE() 宏现在被定义为一个无操作的 if 语句。
-// 编译器会优化掉 'if (1) {}' 部分，从而使得 qDebug() 永远不会被调用，
-// 从而有效地禁用了日志输出，并且不会产生任何运行时开销。
-#define QLOG_TRACE() if (1) {} else qDebug()
-#define QLOG_DEBUG() if (1) {} else qDebug()
-#define QLOG_INFO()  if (1) {} else qDebug()
-#define QLOG_WARN()  if (1) {} else qDebug()
-#define QLOG_ERROR() if (1) {} else qDebug()
-#define QLOG_FATAL() if (1) {} else qDebug()
+// 与编译期移除的日志宏相同，全部展开为 QS_LOG_STRIPPED()：一个永不执行的 if 语句加上 NullStream，
+// 可以接受任意参数、流式写入和 kv() 字段，不会对参数求值，也不会产生任何运行时开销。
+#define QLOG_TRACE(...) QS_LOG_STRIPPED()
+#define QLOG_DEBUG(...) QS_LOG_STRIPPED()
+#define QLOG_INFO(...)  QS_LOG_STRIPPED()
+#define QLOG_WARN(...)  QS_LOG_STRIPPED()
+#define QLOG_ERROR(...) QS_LOG_STRIPPED()
+#define QLOG_FATAL(...) QS_LOG_STRIPPED()
+#define QLOG_TRACE_RAW() QS_LOG_STRIPPED()
+#define QLOG_DEBUG_RAW() QS_LOG_STRIPPED()
+#define QLOG_INFO_RAW()  QS_LOG_STRIPPED()
+#define QLOG_WARN_RAW()  QS_LOG_STRIPPED()
+#define QLOG_ERROR_RAW() QS_LOG_STRIPPED()
+#define QLOG_FATAL_RAW() QS_LOG_STRIPPED()
+#define QLOG_TRACEF(...) QS_LOG_STRIPPED()
+#define QLOG_DEBUGF(...) QS_LOG_STRIPPED()
+#define QLOG_INFOF(...)  QS_LOG_STRIPPED()
+#define QLOG_WARNF(...)  QS_LOG_STRIPPED()
+#define QLOG_ERRORF(...) QS_LOG_STRIPPED()
+#define QLOG_FATALF(...) QS_LOG_STRIPPED()
+#define QLOG_TRACE_EVERY_N(n)    QS_LOG_STRIPPED()
+#define QLOG_TRACE_EVERY_MS(ms)  QS_LOG_STRIPPED()
+#define QLOG_TRACE_SAMPLED(rate) QS_LOG_STRIPPED()
+#define QLOG_TRACE_ONCE()        QS_LOG_STRIPPED()
+#define QLOG_DEBUG_EVERY_N(n)    QS_LOG_STRIPPED()
+#define QLOG_DEBUG_EVERY_MS(ms)  QS_LOG_STRIPPED()
+#define QLOG_DEBUG_SAMPLED(rate) QS_LOG_STRIPPED()
+#define QLOG_DEBUG_ONCE()        QS_LOG_STRIPPED()
+#define QLOG_INFO_EVERY_N(n)    QS_LOG_STRIPPED()
+#define QLOG_INFO_EVERY_MS(ms)  QS_LOG_STRIPPED()
+#define QLOG_INFO_SAMPLED(rate) QS_LOG_STRIPPED()
+#define QLOG_INFO_ONCE()        QS_LOG_STRIPPED()
+#define QLOG_WARN_EVERY_N(n)    QS_LOG_STRIPPED()
+#define QLOG_WARN_EVERY_MS(ms)  QS_LOG_STRIPPED()
+#define QLOG_WARN_SAMPLED(rate) QS_LOG_STRIPPED()
+#define QLOG_WARN_ONCE()        QS_LOG_STRIPPED()
+#define QLOG_ERROR_EVERY_N(n)    QS_LOG_STRIPPED()
+#define QLOG_ERROR_EVERY_MS(ms)  QS_LOG_STRIPPED()
+#define QLOG_ERROR_SAMPLED(rate) QS_LOG_STRIPPED()
+#define QLOG_ERROR_ONCE()        QS_LOG_STRIPPED()
+#define QLOG_FATAL_EVERY_N(n)    QS_LOG_STRIPPED()
+#define QLOG_FATAL_EVERY_MS(ms)  QS_LOG_STRIPPED()
+#define QLOG_FATAL_SAMPLED(rate) QS_LOG_STRIPPED()
+#define QLOG_FATAL_ONCE()        QS_LOG_STRIPPED()
+#define QLOG_CAT_TRACE(category) QS_LOG_STRIPPED()
+#define QLOG_CAT_DEBUG(category) QS_LOG_STRIPPED()
+#define QLOG_CAT_INFO(category) QS_LOG_STRIPPED()
+#define QLOG_CAT_WARN(category) QS_LOG_STRIPPED()
+#define QLOG_CAT_ERROR(category) QS_LOG_STRIPPED()
+#define QLOG_CAT_FATAL(category) QS_LOG_STRIPPED()
 
 #endif // QSLOGDISABLEFORTHISFILE_H
@@ -0,0 +1,196 @@
+﻿#include "QsLogFormat.h"
+#include <QLatin1String>
+#include <cmath>
+#include <cstring>
+
+namespace QsLogging
+{
+
+namespace
+{
+
+// 两位数字查表，每次除以 100 输出两位
+const char DigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// 10 的整数次幂，均可由 double 精确表示
+const double PowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+};
+
+// 把无符号整数写入 end 之前的位置，返回第一个字符的位置
+QChar* writeDigits(quint64 value, QChar* end)
+{
+    QChar* out = end;
+    while (value >= 100) {
+        const int pair = static_cast<int>(value % 100) * 2;
+        value /= 100;
+        *--out = QChar::fromLatin1(DigitPairs[pair + 1]);
+        *--out = QChar::fromLatin1(DigitPairs[pair]);
+    }
+    if (value >= 10) {
+        const int pair = static_cast<int>(value) * 2;
+        *--out = QChar::fromLatin1(DigitPairs[pair + 1]);
+        *--out = QChar::fromLatin1(DigitPairs[pair]);
+    } else {
+        *--out = QChar::fromLatin1(static_cast<char>('0' + value));
+    }
+    return out;
+}
+
+// 追加一段 UTF-8 文本，纯 ASCII 时不经过 UTF-8 解码
+void appendUtf8(QString* text, const char* data, int length)
+{
+    for (int i = 0; i < length; ++i) {
+        if (static_cast<unsigned char>(data[i]) >= 0x80) {
+            text->append(QString::fromUtf8(data, length));
+            return;
+        }
+    }
+    text->append(QLatin1String(data, length));
+}
+
+} // end anonymous namespace
+
+const char* FormatWriter::appendUntilPlaceholder(const char* format)
+{
+    const char* run = format;
+    for (const char* p = format; ; ++p) {
+        if (*p == '\0') {
+            appendUtf8(m_text, run, static_cast<int>(p - run));
+            return nullptr;
+        }
+        if (*p == '{' && p[1] == '}') {
+            appendUtf8(m_text, run, static_cast<int>(p - run));
+            return p + 2;
+        }
+        // "{{" 和 "}}" 输出单个花括号
+        if ((*p == '{' || *p == '}') && p[1] == *p) {
+            appendUtf8(m_text, run, static_cast<int>(p - run) + 1);
+            run = ++p + 1;
+        }
+    }
+}
+
+void FormatWriter::append(bool value)
+{
+    m_text->append(value ? QLatin1String("true") : QLatin1String("false"));
+}
+
+void FormatWriter::append(const char* value)
+{
+    if (value) {
+        appendUtf8(m_text, value, static_cast<int>(std::strlen(value)));
+    }
+}
+
+void FormatWriter::appendInteger(quint64 magnitude, bool negative)
+{
+    // 20 位十进制数字加符号
+    QChar digits[21];
+    QChar* const end = digits + 21;
+    QChar* begin = writeDigits(magnitude, end);
+    if (negative) {
+        *--begin = QLatin1Char('-');
+    }
+    m_text->append(begin, static_cast<int>(end - begin));
+}
+
+void FormatWriter::appendDouble(double value)
+{
+    // 输出与 QDebug 的默认格式（%g，6 位有效数字）一致。定点表示范围内的数值在这里直接转换：
+    // 按 10 的幂缩放后取整得到 6 位有效数字，再去掉末尾的 0
+    if (value == 0 && !std::signbit(value)) {
+        m_text->append(QLatin1Char('0'));
+        return;
+    }
+    const bool negative = value < 0;
+    const double magnitude = negative ? -value : value;
+    if (!(magnitude >= 1e-4 && magnitude < 1e6)) {
+        // 科学计数法、无穷大、NaN 和 -0 交给 Qt 处理
+        m_text->append(QString::number(value, 'g', 6));
+        return;
+    }
+
+    // 十进制指数，满足 10^exponent <= magnitude < 10^(exponent + 1)
+    int exponent = 0;
+    if (magnitude >= 1) {
+        while (exponent < 5 && magnitude >= PowersOfTen[exponent + 1]) {
+            ++exponent;
+        }
+    } else {
+        exponent = -1;
+        while (magnitude * PowersOfTen[-exponent] < 1) {
+            --exponent;
+        }
+    }
+
+    // 缩放后取整。乘积恰好落在 .5 上时用 fma 求出乘法的舍入误差，按真实值判断进位，真正的中点向偶数舍入，与 %g 一致
+    const double scale = PowersOfTen[5 - exponent];
+    const double scaled = magnitude * scale;
+    const double whole = std::floor(scaled);
+    quint64 digits = static_cast<quint64>(whole);
+    const double remainder = scaled - whole;
+    if (remainder > 0.5) {
+        ++digits;
+    } else if (remainder == 0.5) {
+        const double error = std::fma(magnitude, scale, -scaled);
+        if (error > 0 || (error == 0 && (digits & 1))) {
+            ++digits;
+        }
+    }
+    if (digits >= 1000000) {
+        // 进位后多出一位，例如 9.999995 -> 10.0000
+        digits /= 10;
+        if (++exponent > 5) {
+            m_text->append(QString::number(value, 'g', 6));
+            return;
+        }
+    }
+
+    // 小数位数，去掉末尾的 0
+    int fraction = 5 - exponent;
+    while (fraction > 0 && digits % 10 == 0) {
+        digits /= 10;
+        --fraction;
+    }
+
+    // 符号、整数部分、小数点、前导 0 和有效数字：最长为 "-0.000123456"
+    QChar buffer[24];
+    QChar* const end = buffer + 24;
+    QChar* begin = writeDigits(digits, end);
+    if (fraction > 0) {
+        const int written = static_cast<int>(end - begin);
+        // 整数部分为 0 时补足小数点后的前导 0
+        for (int i = written; i < fraction; ++i) {
+            *--begin = QLatin1Char('0');
+        }
+        QChar* const point = end - fraction;
+        if (point == begin) {
+            *--begin = QLatin1Char('.');
+            *--begin = QLatin1Char('0');
+        } else {
+            // 把整数部分前移一位，空出小数点的位置
+            for (QChar* p = begin; p < point; ++p) {
+                *(p - 1) = *p;
+            }
+            --begin;
+            *(point - 1) = QLatin1Char('.');
+        }
+    }
+    if (negative) {
+        *--begin = QLatin1Char('-');
+    }
+    m_text->append(begin, static_cast<int>(end - begin));
+}
+
+} // end namespace QsLogging
@@ -0,0 +1,104 @@
+﻿#ifndef QSLOGFORMAT_H
+#define QSLOGFORMAT_H
+
+#include "QsLogDest.h"
+#include <QByteArray>
+#include <QChar>
+#include <QDebug>
+#include <QString>
+#include <QtGlobal>
+
+namespace QsLogging
+{
+
+// -- 编译期检查格式字符串 --
+// 格式字符串中 "{}" 为占位符，"{{" 和 "}}" 分别输出 '{' 和 '}'，其余的单独花括号视为错误。
+constexpr bool isPlainFormatChar(char c)
+{
+    return c != '\0' && c != '{' && c != '}';
+}
+
+// 返回格式字符串中占位符的个数，格式错误时返回 -1。
+// 连续的普通字符每次跳过 8 个，递归深度约为字符串长度的 1/8，不会触及编译器的 constexpr 递归深度限制
+constexpr int countPlaceholders(const char* format, int count = 0)
+{
+    return *format == '\0' ? count
+         : isPlainFormatChar(format[0]) && isPlainFormatChar(format[1]) && isPlainFormatChar(format[2])
+           && isPlainFormatChar(format[3]) && isPlainFormatChar(format[4]) && isPlainFormatChar(format[5])
+           && isPlainFormatChar(format[6]) && isPlainFormatChar(format[7]) ? countPlaceholders(format + 8, count)
+         : isPlainFormatChar(format[0]) ? countPlaceholders(format + 1, count)
+         : format[0] == '{' && format[1] == '}' ? countPlaceholders(format + 2, count + 1)
+         : format[0] == format[1] ? countPlaceholders(format + 2, count)
+         : -1;
+}
+
+// 格式化日志的输出器：把格式字符串和参数直接追加到文本末尾。
+// 整数和浮点数使用自带的转换，不经过 QTextStream 和区域设置；字符串原样输出，不加引号和空格。
+// 其他类型退回到 QDebug（nospace/noquote）格式化。
+class QSLOG_SHARED_OBJECT FormatWriter
+{
+public:
+    // text 为输出文本，debug 为写入同一文本的 QDebug，用于不支持的类型
+    FormatWriter(QString* text, QDebug* debug) : m_text(text), m_debug(debug) {}
+
+    // 输出格式字符串中下一个占位符之前的内容，返回占位符之后的位置；没有占位符时输出到结尾并返回空指针
+    const char* appendUntilPlaceholder(const char* format);
+
+    void append(bool value);
+    void append(char value) { m_text->append(QChar::fromLatin1(value)); }
+    void append(QChar value) { m_text->append(value); }
+    void append(short value) { appendSigned(value); }
+    void append(unsigned short value) { appendInteger(value, false); }
+    void append(int value) { appendSigned(value); }
+    void append(unsigned int value) { appendInteger(value, false); }
+    void append(long value) { appendSigned(value); }
+    void append(unsigned long value) { appendInteger(value, false); }
+    void append(long long value) { appendSigned(value); }
+    void append(unsigned long long value) { appendInteger(value, false); }
+    void append(float value) { appendDouble(value); }
+    void append(double value) { appendDouble(value); }
+    void append(const char* value);
+    void append(const QString& value) { m_text->append(value); }
+    void append(const QByteArray& value) { m_text->append(QString::fromUtf8(value)); }
+
+    // 其他类型：通过 QDebug 格式化
+    template <typename T>
+    void append(const T& value)
+    {
+        m_debug->nospace().noquote() << value;
+    }
+
+private:
+    template <typename T>
+    void appendSigned(T value)
+    {
+        // 先转换为无符号数再取负，最小值也不会溢出
+        const quint64 magnitude = static_cast<quint64>(static_cast<qint64>(value));
+        appendInteger(value < 0 ? 0 - magnitude : magnitude, value < 0);
+    }
+    void appendInteger(quint64 magnitude, bool negative);
+    void appendDouble(double value);
+
+    QString* m_text;
+    QDebug* m_debug;
+};
+
+// 按顺序把参数填入格式字符串的占位符
+inline void formatArguments(FormatWriter& writer, const char* format)
+{
+    if (format) {
+        writer.appendUntilPlaceholder(format);
+    }
+}
+
+template <typename T, typename... Rest>
+void formatArguments(FormatWriter& writer, const char* format, const T& value, const Rest&... rest)
+{
+    format = format ? writer.appendUntilPlaceholder(format) : nullptr;
+    writer.append(value);
+    formatArguments(writer, format, rest...);
+}
+
+} // end namespace QsLogging
+
+#endif // QSLOGFORMAT_H
@@ -0,0 +1,286 @@
+﻿#include "QsLogJournal.h"
+#include "QsLogClock.h"
+#include "QsLogDestFile.h"
+#include "QsLogRecordEncoder.h"
+#include <QDebug>
+#include <atomic>
+#include <cstring>
+
+namespace QsLogging
+{
+
+// -- 日志环文件格式（本机字节序） --
+// 文件头之后是固定大小的记录区，记录（编码见 QsLogRecordEncoder.h）按 8 字节对齐首尾相接地存放。
+// head 是累计预留的逻辑位置，对记录区大小取模即为文件中的位置，各线程以原子操作推进它来预留空间；
+// 记录区末尾放不下下一条记录时写入回绕标记，读取时跳到记录区开头。
+// 记录写完后才写入魔数，读取时跳过未写完、已作废或被部分覆盖的记录。
+static const char JournalMagic[8] = {'Q', 'S', 'L', 'O', 'G', 'J', 'N', 'L'};
+static const quint32 JournalVersion = 2;
+static const quint32 JournalWrapMagic = 0x57525351;    // "QSRW"
+static const quint32 JournalDiscardMagic = 0x44525351; // "QSRD"，已作废的记录，其后的记录头保持不变
+static const quint64 JournalAlignment = 8;
+// 记录区的最小字节数
+static const qint64 MinJournalCapacity = 64 * 1024;
+
+struct JournalHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 reserved0;
+    quint64 capacity;          // 记录区字节数
+    quint64 head;              // 下一条记录的逻辑位置，预留空间时推进
+    quint64 tail;              // 恢复的起点，之前的记录已经恢复或无需恢复
+    quint64 committedSequence; // 已确认持久化的最大序号
+    char reserved[16];
+};
+
+static_assert(sizeof(std::atomic<quint64>) == sizeof(quint64), "journal head is accessed in place as an atomic");
+
+static quint64 alignJournal(quint64 size)
+{
+    return (size + JournalAlignment - 1) & ~(JournalAlignment - 1);
+}
+
+// 检查文件头是否有效，fileSize 为文件的字节数
+static bool isValidJournal(const JournalHeader& header, qint64 fileSize)
+{
+    return std::memcmp(header.magic, JournalMagic, sizeof(header.magic)) == 0
+        && header.version == JournalVersion
+        && header.capacity > 0 && header.capacity % JournalAlignment == 0
+        && quint64(fileSize) >= sizeof(JournalHeader) + header.capacity
+        && header.tail <= header.head;
+}
+
+Journal::Journal() :
+    m_map(nullptr),
+    m_data(nullptr),
+    m_head(nullptr),
+    m_capacity(0),
+    m_epochOffset(0)
+{
+}
+
+Journal::~Journal()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+    }
+    m_file.close();
+}
+
+bool Journal::open(const QString& journalFilePath, qint64 capacity)
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+        m_data = nullptr;
+        m_head = nullptr;
+    }
+    m_file.close();
+
+    // 上次运行留下的记录尚未恢复时拒绝清空，避免忘记调用 recoverIntoDatabase() 而丢失记录
+    const int unrecovered = readUnflushed(journalFilePath).size();
+    if (unrecovered > 0) {
+        qWarning() << "QsLog: Journal file" << journalFilePath << "still holds" << unrecovered
+                   << "unrecovered record(s); call Journal::recoverIntoDatabase() or remove the file first";
+        return false;
+    }
+
+    m_capacity = alignJournal(quint64(qMax(capacity, MinJournalCapacity)));
+    const qint64 fileSize = qint64(sizeof(JournalHeader) + m_capacity);
+    m_file.setFileName(journalFilePath);
+    // 内容随后整体清零，不需要截断文件
+    if (!m_file.open(QIODevice::ReadWrite) || !m_file.resize(fileSize)) {
+        qWarning() << "QsLog: Failed to create journal file" << journalFilePath << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+    m_map = m_file.map(0, fileSize);
+    if (!m_map) {
+        qWarning() << "QsLog: Failed to map journal file" << journalFilePath << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+    // 预先写满整个映射，分配磁盘空间并建立页映射，之后追加记录时不会因缺页而停顿
+    std::memset(m_map, 0, size_t(fileSize));
+    m_data = m_map + sizeof(JournalHeader);
+    m_epochOffset = Clock::toEpochNanoseconds(0);
+
+    JournalHeader* header = reinterpret_cast<JournalHeader*>(m_map);
+    std::memcpy(header->magic, JournalMagic, sizeof(header->magic));
+    header->version = JournalVersion;
+    header->capacity = m_capacity;
+    m_head = reinterpret_cast<std::atomic<quint64>*>(&header->head);
+    return true;
+}
+
+bool Journal::isOpen() const
+{
+    return m_map != nullptr;
+}
+
+bool Journal::isCurrent(quint64 position) const
+{
+    // 之后预留的空间还没有绕回 position 时，记录头仍属于这条记录
+    return m_head->load(std::memory_order_relaxed) <= position + m_capacity;
+}
+
+quint64 Journal::append(const LogRecord& record)
+{
+    if (!m_map) {
+        return NoPosition;
+    }
+    const RecordEncoder encoder(record, m_epochOffset);
+    const quint64 size = alignJournal(encoder.size());
+    if (size > m_capacity / 4) {
+        return NoPosition;
+    }
+
+    // 预留空间：记录区末尾放不下时连同剩余部分一起预留，由本线程写入回绕标记
+    quint64 head = m_head->load(std::memory_order_relaxed);
+    quint64 offset;
+    quint64 remaining;
+    do {
+        offset = head % m_capacity;
+        remaining = m_capacity - offset;
+    } while (!m_head->compare_exchange_weak(head, head + (remaining < size ? remaining + size : size),
+                                            std::memory_order_relaxed));
+    if (remaining < size) {
+        std::memcpy(m_data + offset, &JournalWrapMagic, sizeof(JournalWrapMagic));
+        head += remaining;
+    }
+
+    // 先作废这个位置上一圈留下的记录头，魔数之外的内容写完后才写入魔数，
+    // 写入中途被杀死时读取方不会把残缺的内容当作记录
+    uchar* entry = m_data + head % m_capacity;
+    const quint32 incomplete = 0;
+    std::memcpy(entry, &incomplete, sizeof(incomplete));
+    std::atomic_thread_fence(std::memory_order_release);
+    uchar* target = entry;
+    auto sink = [&target, entry](const void* data, size_t length) {
+        if (target == entry) {
+            std::memcpy(target + sizeof(quint32), static_cast<const char*>(data) + sizeof(quint32),
+                        length - sizeof(quint32));
+        } else {
+            std::memcpy(target, data, length);
+        }
+        target += length;
+    };
+    encoder.writeTo(sink);
+    std::atomic_thread_fence(std::memory_order_release);
+    const quint32 magic = RecordEncoder::Magic;
+    std::memcpy(entry, &magic, sizeof(magic));
+    return head;
+}
+
+void Journal::setSequence(quint64 position, quint64 sequence)
+{
+    if (m_map && position != NoPosition && isCurrent(position)) {
+        std::memcpy(m_data + position % m_capacity + offsetof(RecordEncoder::Header, sequence), &sequence,
+                    sizeof(sequence));
+    }
+}
+
+void Journal::discard(quint64 position)
+{
+    if (m_map && position != NoPosition && isCurrent(position)) {
+        std::memcpy(m_data + position % m_capacity, &JournalDiscardMagic, sizeof(JournalDiscardMagic));
+    }
+}
+
+void Journal::setCommittedSequence(quint64 sequence)
+{
+    if (m_map) {
+        reinterpret_cast<JournalHeader*>(m_map)->committedSequence = sequence;
+    }
+}
+
+void Journal::markRecovered()
+{
+    if (m_map) {
+        reinterpret_cast<JournalHeader*>(m_map)->tail = m_head->load(std::memory_order_relaxed);
+    }
+}
+
+QVector<RecoveredRecord> Journal::readUnflushed(const QString& journalFilePath)
+{
+    QVector<RecoveredRecord> records;
+    QFile file(journalFilePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return records;
+    }
+    const QByteArray content = file.readAll();
+    JournalHeader header;
+    if (size_t(content.size()) < sizeof(header)) {
+        return records;
+    }
+    std::memcpy(&header, content.constData(), sizeof(header));
+    if (!isValidJournal(header, content.size())) {
+        return records;
+    }
+
+    // 只有最后一圈的内容有效；起点可能落在被部分覆盖的记录中间，按对齐单位向后查找下一条完整的记录
+    const char* data = content.constData() + sizeof(header);
+    RecoveredRecord record;
+    quint64 position = qMax(header.tail, header.head > header.capacity ? header.head - header.capacity : 0);
+    while (position < header.head) {
+        const quint64 offset = position % header.capacity;
+        quint32 magic;
+        std::memcpy(&magic, data + offset, sizeof(magic));
+        if (magic == JournalWrapMagic) {
+            position += header.capacity - offset;
+            continue;
+        }
+        if (magic == JournalDiscardMagic) {
+            RecordEncoder::Header entry;
+            quint64 size = JournalAlignment;
+            if (header.capacity - offset >= sizeof(entry)) {
+                std::memcpy(&entry, data + offset, sizeof(entry));
+                if (entry.size >= sizeof(entry) && entry.size <= header.capacity - offset) {
+                    size = alignJournal(entry.size);
+                }
+            }
+            position += size;
+            continue;
+        }
+        const size_t size = RecordEncoder::decode(data + offset, size_t(header.capacity - offset), record);
+        if (size == 0) {
+            position += JournalAlignment;
+            continue;
+        }
+        // 序号为 0 的记录在写入线程取出之前进程就已退出
+        if (record.sequence == 0 || record.sequence > header.committedSequence) {
+            records.append(record);
+        }
+        position += alignJournal(size);
+    }
+    return records;
+}
+
+int Journal::recoverIntoDatabase(const QString& journalFilePath, DatabaseDestination& database)
+{
+    if (!database.isValid()) {
+        return -1;
+    }
+    const QVector<RecoveredRecord> records = readUnflushed(journalFilePath);
+    if (records.isEmpty()) {
+        return 0;
+    }
+    const int imported = database.importRecords(records);
+    if (imported < 0) {
+        // 保留日志环中的记录，下次启动时重试
+        return -1;
+    }
+    // 清空日志环，重复调用不会再次导入
+    QFile file(journalFilePath);
+    JournalHeader header;
+    if (file.open(QIODevice::ReadWrite)
+        && file.read(reinterpret_cast<char*>(&header), sizeof(header)) == qint64(sizeof(header))) {
+        header.tail = header.head;
+        file.seek(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    return imported;
+}
+
+} // end namespace QsLogging
@@ -0,0 +1,69 @@
+﻿#ifndef QSLOGJOURNAL_H
+#define QSLOGJOURNAL_H
+
+#include "QsLogDest.h"
+#include "QsLogRecord.h"
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <atomic>
+
+namespace QsLogging
+{
+class DatabaseDestination;
+
+// 持久化的日志环：日志调用在入队之前就把记录追加到一个内存映射文件中，写满后覆盖最早的记录。
+// 写入线程取出记录、分配序号后把序号补写到记录中，文件头中同时记下最近一次刷新（Logger::flush()）
+// 或关闭时确认已持久化的序号。映射页由内核持有，进程被 SIGKILL 或 OOM 杀死后内容仍会写回文件，
+// 下次启动时即可找回最后 capacity 字节中尚未确认持久化的记录（包括仍在各线程缓冲区中、尚未分配序号的记录），
+// 而数据库目标无需为每条记录同步磁盘。日志环不调用 msync，不防护操作系统崩溃或断电。
+class QSLOG_SHARED_OBJECT Journal
+{
+public:
+    // 记录区的默认大小
+    static const qint64 DefaultCapacity = 16 * 1024 * 1024;
+    // append() 未写入记录时返回的位置
+    static const quint64 NoPosition = ~quint64(0);
+
+    // 读取日志环中尚未确认持久化的记录（序号大于文件头中已提交的序号），文件不存在或无效时返回空列表
+    static QVector<RecoveredRecord> readUnflushed(const QString& journalFilePath);
+    // 把尚未确认持久化的记录写入数据库（已存在的记录会被跳过），随后把这些记录标记为已恢复。
+    // 返回写入的条数，数据库不可用或写入失败时返回 -1。应在 Logger::enableJournal() 之前调用
+    static int recoverIntoDatabase(const QString& journalFilePath, DatabaseDestination& database);
+
+    Journal();
+    ~Journal();
+
+    // 创建或清空日志环文件并映射到内存。文件中仍有尚未恢复的记录时不会清空它，输出警告后返回 false
+    bool open(const QString& journalFilePath, qint64 capacity = DefaultCapacity);
+    bool isOpen() const;
+    // 追加一条记录并返回它的位置，可由多个线程同时调用；超过容量四分之一的记录不写入，返回 NoPosition
+    quint64 append(const LogRecord& record);
+    // 把写入线程分配的序号补写到 position 处的记录中，记录已被覆盖时忽略
+    void setSequence(quint64 position, quint64 sequence);
+    // 作废 position 处的记录（例如因队列溢出被丢弃），恢复时跳过；记录已被覆盖时忽略
+    void discard(quint64 position);
+    // 记下已持久化的最大序号，只由写入线程调用
+    void setCommittedSequence(quint64 sequence);
+    // 把现有的记录都标记为无需恢复，停用日志环时调用：其中的记录仍由日志器照常写出
+    void markRecovered();
+
+private:
+    Journal(const Journal&);
+    Journal& operator=(const Journal&);
+
+    // position 处的记录尚未被之后的记录覆盖时返回 true
+    bool isCurrent(quint64 position) const;
+
+    QFile m_file;
+    uchar* m_map;       // 映射的整个文件：文件头及其后的记录区
+    uchar* m_data;      // 记录区
+    std::atomic<quint64>* m_head; // 文件头中的写入位置，各线程以原子操作预留空间
+    quint64 m_capacity; // 记录区字节数
+    qint64 m_epochOffset; // 单调时钟读数换算为纪元纳秒的偏移
+};
+
+} // end namespace QsLogging
+
+#endif // QSLOGJOURNAL_H
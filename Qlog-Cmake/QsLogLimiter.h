@@ -0,0 +1,115 @@
+﻿#ifndef QSLOGLIMITER_H
+#define QSLOGLIMITER_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <chrono>
+
+namespace QsLogging
+{
+
+// 限流日志宏使用的调用点限流器。每个调用点持有一个静态实例，
+// 构造函数为 constexpr，静态实例在编译期完成初始化，判断过程只使用原子操作，不加锁。
+
+// 每 n 次调用输出一次（第 1、n+1、2n+1 ... 次）
+class EveryNLimiter
+{
+public:
+    typedef quint64 Parameter;
+
+    constexpr EveryNLimiter() : m_count(0) {}
+
+    bool allow(Parameter n)
+    {
+        const quint64 count = m_count.fetch_add(1, std::memory_order_relaxed);
+        return n <= 1 || count % n == 0;
+    }
+
+private:
+    std::atomic<quint64> m_count;
+};
+
+// 两次输出之间至少间隔指定的毫秒数，期间的调用全部被抑制
+class IntervalLimiter
+{
+public:
+    typedef qint64 Parameter;
+
+    constexpr IntervalLimiter() : m_next(0) {}
+
+    bool allow(Parameter msecs)
+    {
+        const qint64 now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        qint64 next = m_next.load(std::memory_order_relaxed);
+        if (now < next) {
+            return false;
+        }
+        // 多个线程同时到期时只有一个能推进下一次输出的时间
+        return m_next.compare_exchange_strong(next, now + msecs, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<qint64> m_next;
+};
+
+// 按概率抽样输出，rate 取值 0.0 ~ 1.0
+class SampleLimiter
+{
+public:
+    typedef double Parameter;
+
+    constexpr SampleLimiter() {}
+
+    bool allow(Parameter rate)
+    {
+        if (rate >= 1.0) {
+            return true;
+        }
+        if (rate <= 0.0) {
+            return false;
+        }
+        return static_cast<double>(nextRandom() >> 11) * (1.0 / 9007199254740992.0) < rate;
+    }
+
+private:
+    // 每个线程独立的 xorshift64* 随机数序列，无需同步
+    static quint64 nextRandom()
+    {
+        static thread_local quint64 state = 0;
+        if (state == 0) {
+            state = static_cast<quint64>(reinterpret_cast<quintptr>(&state))
+                    ^ static_cast<quint64>(std::chrono::steady_clock::now().time_since_epoch().count())
+                    ^ Q_UINT64_C(0x9E3779B97F4A7C15);
+            if (state == 0) {
+                state = 1;
+            }
+        }
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * Q_UINT64_C(2685821657736338717);
+    }
+};
+
+// 只输出第一次调用
+class OnceLimiter
+{
+public:
+    typedef int Parameter;
+
+    constexpr OnceLimiter() : m_fired(false) {}
+
+    bool allow(Parameter)
+    {
+        return !m_fired.load(std::memory_order_relaxed)
+               && !m_fired.exchange(true, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic_bool m_fired;
+};
+
+} // end namespace QsLogging
+
+#endif // QSLOGLIMITER_H
@@ -0,0 +1,125 @@
+﻿#include "QsLogRecord.h"
+#include "QsLogArguments.h"
+#include "QsLogClock.h"
+#include "QsLogRecordPool.h"
+#include "QsLogSite.h"
+
+namespace QsLogging
+{
+
+LogRecord::LogRecord(Level level, const LogMetadata& metadata, const QString& message, const LogFields& fields) :
+    m_level(level),
+    m_metadata(metadata),
+    m_message(message),
+    m_fields(fields),
+    m_encoding(PlainText),
+    m_refCount(0),
+    m_pooled(false)
+{
+}
+
+LogRecord::LogRecord(const LogRecord& other) :
+    m_level(other.m_level),
+    m_metadata(other.m_metadata),
+    m_message(other.m_message),
+    m_fields(other.m_fields),
+    m_encoding(other.m_encoding),
+    m_payload(other.m_payload),
+    m_refCount(0),
+    m_pooled(false)
+{
+}
+
+LogRecord::LogRecord() :
+    m_level(TraceLevel),
+    m_encoding(PlainText),
+    m_refCount(0),
+    m_pooled(false)
+{
+}
+
+QDateTime LogRecord::dateTime() const
+{
+    return Clock::toDateTime(m_metadata.timestamp);
+}
+
+const char* LogRecord::file() const
+{
+    return m_metadata.site ? m_metadata.site->file : nullptr;
+}
+
+int LogRecord::line() const
+{
+    return m_metadata.site ? m_metadata.site->line : 0;
+}
+
+const char* LogRecord::function() const
+{
+    return m_metadata.site ? m_metadata.site->function : nullptr;
+}
+
+const char* LogRecord::category() const
+{
+    return m_metadata.site ? m_metadata.site->category : nullptr;
+}
+
+qint64 LogRecord::approximateSize() const
+{
+    return qint64(sizeof(LogRecord)) + qint64(m_message.size()) * 2 + m_payload.size()
+        + qint64(m_metadata.threadName.size()) * 2;
+}
+
+void LogRecord::decode()
+{
+    if (m_encoding == DeferredArguments) {
+        m_message = DeferredStream::format(m_payload);
+    } else if (m_encoding == StructuredFields) {
+        StructuredStream::decode(m_payload, &m_message, &m_fields);
+    }
+    m_encoding = PlainText;
+    // 保留容量，记录回到对象池后可以继续使用
+    m_payload.resize(0);
+}
+
+// -- LogRecordPtr 实现 --
+LogRecordPtr::LogRecordPtr(const LogRecord* record) :
+    m_record(const_cast<LogRecord*>(record))
+{
+    if (m_record) {
+        m_record->m_refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+LogRecordPtr::LogRecordPtr(const LogRecordPtr& other) :
+    m_record(other.m_record)
+{
+    if (m_record) {
+        m_record->m_refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+LogRecordPtr& LogRecordPtr::operator=(const LogRecordPtr& other)
+{
+    if (other.m_record) {
+        other.m_record->m_refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    clear();
+    m_record = other.m_record;
+    return *this;
+}
+
+void LogRecordPtr::release()
+{
+    LogRecord* record = m_record;
+    m_record = nullptr;
+    // 最后一个引用：之前所有持有者对记录的访问都先于回收或删除
+    if (record->m_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        if (record->m_pooled) {
+            RecordPool::instance().recycle(record);
+        } else {
+            delete record;
+        }
+    }
+}
+
+} // end namespace QsLogging
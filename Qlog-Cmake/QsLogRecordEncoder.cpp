@@ -0,0 +1,131 @@
+﻿#include "QsLogRecordEncoder.h"
+#include "QsLogArguments.h"
+#include "QsLogSite.h"
+#include <cstring>
+
+namespace QsLogging
+{
+
+// 消息部分的编码，与 LogRecord::Encoding 一一对应
+enum EncodedMessage
+{
+    EncodedPlainText = 0,         // UTF-16 文本
+    EncodedDeferredArguments = 1, // DeferredStream 的参数记录
+    EncodedStructuredFields = 2   // StructuredStream 的消息与字段记录
+};
+
+// 单条记录的上限，用于识别损坏的记录头
+static const quint32 MaxEncodedRecordSize = 256 * 1024 * 1024;
+
+RecordEncoder::RecordEncoder(const LogRecord& record, qint64 epochOffset)
+{
+    const LogSite* site = record.m_metadata.site;
+    m_pieces[0] = site && site->file ? site->file : "";
+    m_pieces[1] = site && site->function ? site->function : "";
+    m_pieces[2] = site && site->format ? site->format : "";
+    m_pieces[3] = site && site->category ? site->category : "";
+    for (int i = 0; i < 4; ++i) {
+        m_pieceSizes[i] = std::strlen(m_pieces[i]);
+    }
+    const QString& threadName = record.m_metadata.threadName;
+    m_pieces[4] = reinterpret_cast<const char*>(threadName.constData());
+    m_pieceSizes[4] = size_t(threadName.size()) * sizeof(QChar);
+
+    std::memset(&m_header, 0, sizeof(m_header));
+    // 只读取记录已有的数据：尚未还原的内容按原始字节保存
+    if (record.m_encoding == LogRecord::PlainText) {
+        m_header.encoding = EncodedPlainText;
+        m_pieces[5] = reinterpret_cast<const char*>(record.m_message.constData());
+        m_pieceSizes[5] = size_t(record.m_message.size()) * sizeof(QChar);
+    } else {
+        m_header.encoding = record.m_encoding == LogRecord::DeferredArguments ? EncodedDeferredArguments
+                                                                              : EncodedStructuredFields;
+        m_pieces[5] = record.m_payload.constData();
+        m_pieceSizes[5] = size_t(record.m_payload.size());
+    }
+
+    size_t size = sizeof(m_header) + PieceCount * sizeof(quint32);
+    for (int i = 0; i < PieceCount; ++i) {
+        size += m_pieceSizes[i];
+    }
+    m_header.magic = Magic;
+    m_header.size = static_cast<quint32>(size);
+    m_header.level = static_cast<quint8>(record.m_level);
+    m_header.line = site ? site->line : 0;
+    m_header.epochNanoseconds = record.m_metadata.timestamp + epochOffset;
+    m_header.threadId = record.m_metadata.threadId;
+    m_header.sequence = record.m_metadata.sequence;
+}
+
+static QString fromEncodedUtf16(const char* data, quint32 size)
+{
+    return QString(reinterpret_cast<const QChar*>(data), int(size / sizeof(QChar)));
+}
+
+size_t RecordEncoder::decode(const char* data, size_t available, RecoveredRecord& record)
+{
+    Header header;
+    if (available < sizeof(header)) {
+        return 0;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != Magic || header.size < sizeof(header) + PieceCount * sizeof(quint32)
+        || header.size > MaxEncodedRecordSize || header.size > available) {
+        return 0;
+    }
+
+    // 各部分的位置与长度，越界时视为不完整的记录
+    const char* pieces[PieceCount];
+    quint32 sizes[PieceCount];
+    size_t offset = sizeof(header);
+    for (int i = 0; i < PieceCount; ++i) {
+        if (header.size - offset < sizeof(quint32)) {
+            return 0;
+        }
+        std::memcpy(&sizes[i], data + offset, sizeof(quint32));
+        offset += sizeof(quint32);
+        if (header.size - offset < sizes[i]) {
+            return 0;
+        }
+        pieces[i] = data + offset;
+        offset += sizes[i];
+    }
+
+    record.level = static_cast<Level>(header.level);
+    record.epochNanoseconds = header.epochNanoseconds;
+    record.threadId = header.threadId;
+    record.sequence = header.sequence;
+    record.file = QString::fromUtf8(pieces[0], int(sizes[0]));
+    record.line = header.line;
+    record.function = QString::fromUtf8(pieces[1], int(sizes[1]));
+    record.format = QString::fromUtf8(pieces[2], int(sizes[2]));
+    record.category = QString::fromUtf8(pieces[3], int(sizes[3]));
+    record.threadName = fromEncodedUtf16(pieces[4], sizes[4]);
+    record.message.clear();
+    record.fields.clear();
+    // 参数记录来自外部文件，可能已经损坏或来自编码不同的版本：无法完整还原时保留这条记录，
+    // 消息换成说明文字，不再继续解析其中的内容
+    bool decoded = true;
+    switch (header.encoding) {
+    case EncodedDeferredArguments:
+        // 流操作函数指针（如 hex）属于原来的进程，不能在这里调用
+        record.message = DeferredStream::format(QByteArray(pieces[5], int(sizes[5])), false, &decoded);
+        break;
+    case EncodedStructuredFields:
+        decoded = StructuredStream::decode(QByteArray(pieces[5], int(sizes[5])), &record.message, &record.fields);
+        break;
+    case EncodedPlainText:
+        record.message = fromEncodedUtf16(pieces[5], sizes[5]);
+        break;
+    default:
+        decoded = false;
+        break;
+    }
+    if (!decoded) {
+        record.message = QString("<QsLog: undecodable message, %1 bytes>").arg(sizes[5]);
+        record.fields.clear();
+    }
+    return header.size;
+}
+
+} // end namespace QsLogging
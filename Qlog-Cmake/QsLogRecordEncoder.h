@@ -0,0 +1,66 @@
+﻿#ifndef QSLOGRECORDENCODER_H
+#define QSLOGRECORDENCODER_H
+
+#include "QsLogRecord.h"
+#include <QtGlobal>
+#include <cstddef>
+
+namespace QsLogging
+{
+
+// 日志记录的二进制编码（本机字节序），崩溃转储文件与持久化日志环共用。
+// 固定的记录头之后依次是 file、function、format、category（UTF-8）、线程名称（UTF-16）和消息，
+// 各自以 quint32 字节数开头。消息按记录当前的编码保存：已还原的文本为 UTF-16，
+// 延迟格式化与结构化的内容保存原始参数记录，解码时再还原。
+class RecordEncoder
+{
+public:
+    static const quint32 Magic = 0x524C5351; // "QSLR"
+
+    struct Header
+    {
+        quint32 magic;
+        quint32 size;     // 整条记录的字节数，含本结构
+        quint8 level;
+        quint8 encoding;  // 消息部分的编码，见 QsLogRecordEncoder.cpp
+        quint16 reserved;
+        qint32 line;
+        qint64 epochNanoseconds;
+        quint64 threadId;
+        quint64 sequence;
+    };
+
+    // 只计算各部分的位置和长度，不加锁、不分配内存，可以在崩溃处理函数中使用。
+    // epochOffset 为单调时钟读数换算为纪元纳秒的偏移（Clock::toEpochNanoseconds(0)）
+    RecordEncoder(const LogRecord& record, qint64 epochOffset);
+
+    // 编码后的总字节数
+    size_t size() const { return m_header.size; }
+    // 依次把编码后的各部分交给 sink(data, size)
+    template <typename Sink>
+    void writeTo(Sink& sink) const
+    {
+        sink(&m_header, sizeof(m_header));
+        for (int i = 0; i < PieceCount; ++i) {
+            const quint32 length = static_cast<quint32>(m_pieceSizes[i]);
+            sink(&length, sizeof(length));
+            if (length > 0) {
+                sink(m_pieces[i], m_pieceSizes[i]);
+            }
+        }
+    }
+
+    // 解码 data 开头的一条记录，成功时返回其字节数；数据不完整或不是记录时返回 0
+    static size_t decode(const char* data, size_t available, RecoveredRecord& record);
+
+private:
+    enum { PieceCount = 6 };
+
+    Header m_header;
+    const char* m_pieces[PieceCount];
+    size_t m_pieceSizes[PieceCount];
+};
+
+} // end namespace QsLogging
+
+#endif // QSLOGRECORDENCODER_H
@@ -0,0 +1,79 @@
+﻿#include "QsLogRecordPool.h"
+
+namespace QsLogging
+{
+
+RecordPool& RecordPool::instance()
+{
+    // 有意不销毁：退出时 Logger 与异步目标仍可能释放记录
+    static RecordPool* const pool = new RecordPool();
+    return *pool;
+}
+
+RecordPool::RecordPool() :
+    m_free(MaxPooledRecords),
+    m_slabCount(0)
+{
+}
+
+LogRecord* RecordPool::acquire()
+{
+    LogRecord* record = nullptr;
+    // 空闲记录可能刚被其他线程取走，增长后再取一次
+    if (m_free.tryPop(record) || (grow() && m_free.tryPop(record))) {
+        return record;
+    }
+    return new LogRecord();
+}
+
+void RecordPool::recycle(LogRecord* record)
+{
+    // 清空内容，保留缓冲区的容量；仍被目的地保留的文本在这里与记录分离
+    record->m_metadata = LogMetadata();
+    if (!record->m_message.isDetached() || record->m_message.capacity() > RetainedCapacity) {
+        record->m_message = QString();
+        record->m_message.reserve(InlineMessageCapacity);
+    } else {
+        record->m_message.resize(0);
+    }
+    if (!record->m_payload.isDetached() || record->m_payload.capacity() > RetainedCapacity) {
+        record->m_payload = QByteArray();
+        record->m_payload.reserve(InlinePayloadCapacity);
+    } else {
+        record->m_payload.resize(0);
+    }
+    record->m_fields.clear();
+    record->m_encoding = LogRecord::PlainText;
+    // 池中的记录总数不超过空闲列表的容量，归还一定成功
+    m_free.tryPush(std::move(record));
+}
+
+int RecordPool::slabCount() const
+{
+    return m_slabCount.load(std::memory_order_relaxed);
+}
+
+bool RecordPool::grow()
+{
+    QMutexLocker locker(&m_growMutex);
+    if (!m_free.isEmpty()) {
+        // 其他线程刚刚增长过
+        return true;
+    }
+    if ((m_slabs.size() + 1) * SlabRecords > MaxPooledRecords) {
+        return false;
+    }
+    LogRecord* slab = new LogRecord[SlabRecords];
+    m_slabs.append(slab);
+    m_slabCount.store(m_slabs.size(), std::memory_order_relaxed);
+    for (int i = 0; i < SlabRecords; ++i) {
+        LogRecord* record = slab + i;
+        record->m_pooled = true;
+        record->m_message.reserve(InlineMessageCapacity);
+        record->m_payload.reserve(InlinePayloadCapacity);
+        m_free.tryPush(std::move(record));
+    }
+    return true;
+}
+
+} // end namespace QsLogging
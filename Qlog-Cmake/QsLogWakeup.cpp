@@ -0,0 +1,160 @@
+﻿#include "QsLogWakeup.h"
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_LINUX)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace QsLogging
+{
+
+#if defined(Q_OS_WIN)
+
+WakeupNotifier::WakeupNotifier() :
+    m_readHandle(-1),
+    m_writeHandle(-1)
+{
+    // 手动重置：通知一直保持，直到 clear() 被调用
+    HANDLE event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (event) {
+        m_readHandle = m_writeHandle = reinterpret_cast<qintptr>(event);
+    }
+}
+
+WakeupNotifier::~WakeupNotifier()
+{
+    if (isValid()) {
+        CloseHandle(reinterpret_cast<HANDLE>(m_readHandle));
+    }
+}
+
+void WakeupNotifier::notify()
+{
+    if (isValid()) {
+        SetEvent(reinterpret_cast<HANDLE>(m_writeHandle));
+    }
+}
+
+void WakeupNotifier::clear()
+{
+    if (isValid()) {
+        ResetEvent(reinterpret_cast<HANDLE>(m_readHandle));
+    }
+}
+
+#elif defined(Q_OS_LINUX)
+
+WakeupNotifier::WakeupNotifier() :
+    m_readHandle(-1),
+    m_writeHandle(-1)
+{
+    const int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd >= 0) {
+        m_readHandle = m_writeHandle = fd;
+    }
+}
+
+WakeupNotifier::~WakeupNotifier()
+{
+    if (isValid()) {
+        ::close(static_cast<int>(m_readHandle));
+    }
+}
+
+void WakeupNotifier::notify()
+{
+    if (!isValid()) {
+        return;
+    }
+    const uint64_t one = 1;
+    // 计数器累加，不会因已有通知而失败
+    while (::write(static_cast<int>(m_writeHandle), &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+}
+
+void WakeupNotifier::clear()
+{
+    if (!isValid()) {
+        return;
+    }
+    uint64_t value;
+    // 读取即清零，没有通知时返回 EAGAIN
+    while (::read(static_cast<int>(m_readHandle), &value, sizeof(value)) < 0 && errno == EINTR) {
+    }
+}
+
+#else
+
+WakeupNotifier::WakeupNotifier() :
+    m_readHandle(-1),
+    m_writeHandle(-1)
+{
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        return;
+    }
+    for (int fd : fds) {
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    m_readHandle = fds[0];
+    m_writeHandle = fds[1];
+}
+
+WakeupNotifier::~WakeupNotifier()
+{
+    if (isValid()) {
+        ::close(static_cast<int>(m_readHandle));
+        ::close(static_cast<int>(m_writeHandle));
+    }
+}
+
+void WakeupNotifier::notify()
+{
+    if (!isValid()) {
+        return;
+    }
+    const char byte = 1;
+    // 管道已满时写入失败也无妨，读端已经可读
+    while (::write(static_cast<int>(m_writeHandle), &byte, 1) < 0 && errno == EINTR) {
+    }
+}
+
+void WakeupNotifier::clear()
+{
+    if (!isValid()) {
+        return;
+    }
+    char buffer[64];
+    for (;;) {
+        const ssize_t count = ::read(static_cast<int>(m_readHandle), buffer, sizeof(buffer));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < static_cast<ssize_t>(sizeof(buffer))) {
+            break;
+        }
+    }
+}
+
+#endif
+
+bool WakeupNotifier::isValid() const
+{
+    return m_readHandle != -1;
+}
+
+qintptr WakeupNotifier::handle() const
+{
+    return m_readHandle;
+}
+
+} // end namespace QsLogging
@@ -0,0 +1,37 @@
+﻿#ifndef QSLOGWAKEUP_H
+#define QSLOGWAKEUP_H
+
+#include <QtGlobal>
+
+namespace QsLogging
+{
+
+// 可被事件循环监听的唤醒通知（类似 eventfd）。
+// Linux 上使用 eventfd，其他 Unix 系统使用非阻塞管道，Windows 上使用手动重置的事件对象。
+// notify() 使句柄变为可读（有信号），clear() 将其恢复，两者都可以在任意线程调用。
+class WakeupNotifier
+{
+public:
+    WakeupNotifier();
+    ~WakeupNotifier();
+
+    // 句柄是否创建成功
+    bool isValid() const;
+    // 供 QSocketNotifier（Unix 文件描述符）或 QWinEventNotifier（Windows HANDLE）监听的句柄，失败时为 -1
+    qintptr handle() const;
+    // 发出通知，多次通知在 clear() 之前合并为一次
+    void notify();
+    // 清除已发出的通知
+    void clear();
+
+private:
+    WakeupNotifier(const WakeupNotifier&);
+    WakeupNotifier& operator=(const WakeupNotifier&);
+
+    qintptr m_readHandle;  // 被监听的一端
+    qintptr m_writeHandle; // 写入通知的一端，eventfd 与事件对象两端相同
+};
+
+} // end namespace QsLogging
+
+#endif // QSLOGWAKEUP_H
@@ -0,0 +1,131 @@
+﻿// 稳定运行时日志调用不分配内存：替换 glibc 的 malloc 系列函数，统计调用线程上的堆分配次数。
+// 先让记录对象池、线程缓冲区和格式化缓冲区在预热中达到所需的大小，之后每条日志的分配次数必须为 0。
+// 只替换本测试程序的分配函数；非 glibc 平台上无法转发给原来的实现，直接跳过。
+#include "QsLog.h"
+#include "QsLogDest.h"
+#include <QCoreApplication>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+
+// ctest 按 SKIP_RETURN_CODE 识别为跳过
+static const int SkipReturnCode = 77;
+
+#if defined(__GLIBC__)
+// operator new 与 Qt 容器的分配都会经过这些函数，对齐分配也要统计，例如对齐的 operator new
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+extern "C" void* __libc_memalign(size_t alignment, size_t size);
+
+static thread_local unsigned long long heapAllocations = 0;
+
+extern "C" void* malloc(size_t size) throw()
+{
+    ++heapAllocations;
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) throw()
+{
+    ++heapAllocations;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) throw()
+{
+    ++heapAllocations;
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void* memalign(size_t alignment, size_t size) throw()
+{
+    ++heapAllocations;
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void* aligned_alloc(size_t alignment, size_t size) throw()
+{
+    ++heapAllocations;
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void** pointer, size_t alignment, size_t size) throw()
+{
+    ++heapAllocations;
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void* result = __libc_memalign(alignment, size);
+    if (!result) {
+        return ENOMEM;
+    }
+    *pointer = result;
+    return 0;
+}
+
+namespace
+{
+
+// 只计数的日志目的地，写入线程上的分配不影响调用线程的统计
+class CountingDestination : public QsLogging::Destination
+{
+public:
+    CountingDestination() : count(0) {}
+
+    void write(const QString&, QsLogging::Level) override { count.fetch_add(1, std::memory_order_relaxed); }
+    bool isValid() override { return true; }
+
+    std::atomic<long long> count;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication application(argc, argv);
+    QsLogging::Logger& logger = QsLogging::Logger::instance();
+    QSharedPointer<CountingDestination> destination(new CountingDestination);
+    logger.addDestination(destination);
+
+    // 每轮的条数小于线程缓冲区的容量，预热两轮后对象池中的记录足够一轮使用。
+    // 只使用整数参数，浮点数的格式化本身会分配内存
+    const int iterations = 1000;
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < iterations; ++i) {
+            QLOG_INFOF("conn {} took {} us", i, i * 3);
+        }
+        logger.flush();
+    }
+
+    const unsigned long long before = heapAllocations;
+    for (int i = 0; i < iterations; ++i) {
+        QLOG_INFOF("conn {} took {} us", i, i * 3);
+    }
+    const unsigned long long allocations = heapAllocations - before;
+    logger.flush();
+
+    std::printf("heap allocations on the calling thread: %llu for %d messages\n", allocations, iterations);
+    if (destination->count.load(std::memory_order_relaxed) != 3LL * iterations) {
+        std::fprintf(stderr, "expected %d records, the destination received %lld\n", 3 * iterations,
+                     destination->count.load(std::memory_order_relaxed));
+        return 1;
+    }
+    if (allocations != 0) {
+        std::fprintf(stderr, "steady-state logging allocated %.3f times per message\n",
+                     double(allocations) / iterations);
+        return 1;
+    }
+    return 0;
+}
+
+#else
+
+int main()
+{
+    std::printf("allocation counting needs glibc, skipped\n");
+    return SkipReturnCode;
+}
+
+#endif
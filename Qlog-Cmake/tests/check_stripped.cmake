@@ -0,0 +1,24 @@
+﻿# 检查以 QS_LOG_COMPILE_LEVEL=2 编译的探针目标文件（compile_level_probe.cpp）：
+# TRACE/DEBUG 调用点的字符串常量与参数函数都不应出现，INFO 调用点的参数函数必须出现，
+# 后者确认检查的确实是探针的目标文件。用法：cmake -DOBJECT=<目标文件> -P check_stripped.cmake
+if(NOT OBJECT OR NOT EXISTS "${OBJECT}")
+    message(FATAL_ERROR "probe object file not found: '${OBJECT}'")
+endif()
+
+file(STRINGS "${OBJECT}" probeStrings REGEX "QSLOG_PROBE_|qslogProbe")
+
+set(leaked "")
+foreach(entry IN LISTS probeStrings)
+    if(entry MATCHES "QSLOG_PROBE_(TRACE|DEBUG)|qslogProbe(Trace|Debug)Argument")
+        list(APPEND leaked "${entry}")
+    endif()
+endforeach()
+if(leaked)
+    message(FATAL_ERROR "stripped log statements left traces in ${OBJECT}:\n  ${leaked}")
+endif()
+
+if(NOT probeStrings MATCHES "qslogProbeInfoArgument")
+    message(FATAL_ERROR "INFO statement missing from ${OBJECT}, is this the probe object?")
+endif()
+
+message(STATUS "TRACE/DEBUG statements stripped from ${OBJECT}")
@@ -0,0 +1,33 @@
+﻿// QS_LOG_COMPILE_LEVEL 的探针：由 tests/CMakeLists.txt 以 QS_LOG_COMPILE_LEVEL=2 编译为目标文件，
+// check_stripped.cmake 检查其中不含 TRACE/DEBUG 调用点的字符串常量与参数函数的引用，
+// 而 INFO 调用点的参数函数仍被引用。参数函数只有声明，被求值时目标文件中才会出现对它的引用
+#include "QsLog.h"
+#include "QsLogCategory.h"
+
+int qslogProbeTraceArgument();
+int qslogProbeDebugArgument();
+int qslogProbeInfoArgument();
+
+static QsLogging::Category probeCategory("qslog.probe");
+
+void qslogCompileLevelProbe()
+{
+    QLOG_TRACE() << "QSLOG_PROBE_TRACE_STREAM" << qslogProbeTraceArgument();
+    QLOG_TRACE("QSLOG_PROBE_TRACE_STRUCTURED").kv("value", qslogProbeTraceArgument());
+    QLOG_TRACE_RAW() << "QSLOG_PROBE_TRACE_RAW" << qslogProbeTraceArgument();
+    QLOG_TRACEF("QSLOG_PROBE_TRACE_FORMAT {}", qslogProbeTraceArgument());
+    QLOG_TRACE_EVERY_N(10) << "QSLOG_PROBE_TRACE_EVERY_N" << qslogProbeTraceArgument();
+    QLOG_TRACE_ONCE() << "QSLOG_PROBE_TRACE_ONCE" << qslogProbeTraceArgument();
+    QLOG_CAT_TRACE(probeCategory) << "QSLOG_PROBE_TRACE_CATEGORY" << qslogProbeTraceArgument();
+
+    QLOG_DEBUG() << "QSLOG_PROBE_DEBUG_STREAM" << qslogProbeDebugArgument();
+    QLOG_DEBUG("QSLOG_PROBE_DEBUG_STRUCTURED").kv("value", qslogProbeDebugArgument());
+    QLOG_DEBUG_RAW() << "QSLOG_PROBE_DEBUG_RAW" << qslogProbeDebugArgument();
+    QLOG_DEBUGF("QSLOG_PROBE_DEBUG_FORMAT {}", qslogProbeDebugArgument());
+    QLOG_DEBUG_EVERY_MS(1000) << "QSLOG_PROBE_DEBUG_EVERY_MS" << qslogProbeDebugArgument();
+    QLOG_DEBUG_SAMPLED(0.5) << "QSLOG_PROBE_DEBUG_SAMPLED" << qslogProbeDebugArgument();
+    QLOG_CAT_DEBUG(probeCategory) << "QSLOG_PROBE_DEBUG_CATEGORY" << qslogProbeDebugArgument();
+
+    // 对照：INFO 及以上的调用点保留
+    QLOG_INFO() << "info" << qslogProbeInfoArgument();
+}
@@ -0,0 +1,195 @@
+﻿// 日志传输队列的吞吐量基准：对比原来的互斥锁队列（以 std::mutex + std::deque 代替 QMutex + QQueue）、
+// 多生产者共享的无锁环形缓冲区（RingBuffer），以及每个生产者独占的单生产者缓冲区（SpscRingBuffer，
+// 由唯一的消费者轮询，即 LoggerImpl 当前的传输方式）。只依赖 QsLogRingBuffer.h，不需要 Qt。
+//
+// 用法：ringbuffer_benchmark [--messages 每个生产者的消息数] [--max-producers 最大生产者数]
+// 生产者数从 1 开始逐次翻倍，直到 max-producers。多核机器上才能看出随线程数增长的扩展性。
+#include "QsLogRingBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace QsLogging;
+
+namespace
+{
+
+// 与 LogMessage 大小相近的消息：记录指针与计入预算的字节数
+struct Message
+{
+    Message() : record(nullptr), bytes(0) {}
+    Message(void* r, long long b) : record(r), bytes(b) {}
+
+    void* record;
+    long long bytes;
+};
+
+const size_t QueueCapacity = 4096;
+
+// 原来的设计：生产者与消费者每条消息都获取同一个互斥锁
+class MutexQueue
+{
+public:
+    explicit MutexQueue(size_t capacity) : m_capacity(capacity) {}
+
+    bool tryPush(Message&& message)
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        if (m_queue.size() >= m_capacity) {
+            return false;
+        }
+        m_queue.push_back(message);
+        return true;
+    }
+
+    bool tryPop(Message& message)
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        if (m_queue.empty()) {
+            return false;
+        }
+        message = m_queue.front();
+        m_queue.pop_front();
+        return true;
+    }
+
+private:
+    const size_t m_capacity;
+    std::mutex m_mutex;
+    std::deque<Message> m_queue;
+};
+
+// 所有生产者共用一个队列
+template <typename Queue>
+class SharedTransport
+{
+public:
+    explicit SharedTransport(int) : m_queue(QueueCapacity) {}
+
+    bool tryPush(int, Message&& message) { return m_queue.tryPush(std::move(message)); }
+    bool tryPop(Message& message) { return m_queue.tryPop(message); }
+
+private:
+    Queue m_queue;
+};
+
+// 每个生产者一个单生产者/单消费者缓冲区，消费者轮询所有缓冲区
+class PerThreadTransport
+{
+public:
+    explicit PerThreadTransport(int producers) : m_next(0)
+    {
+        for (int i = 0; i < producers; ++i) {
+            m_buffers.push_back(std::unique_ptr<SpscRingBuffer<Message> >(new SpscRingBuffer<Message>(QueueCapacity)));
+        }
+    }
+
+    bool tryPush(int producer, Message&& message) { return m_buffers[producer]->tryPush(std::move(message)); }
+
+    bool tryPop(Message& message)
+    {
+        const size_t count = m_buffers.size();
+        for (size_t i = 0; i < count; ++i) {
+            SpscRingBuffer<Message>& buffer = *m_buffers[m_next];
+            m_next = (m_next + 1) % count;
+            if (buffer.tryPop(message)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    std::vector<std::unique_ptr<SpscRingBuffer<Message> > > m_buffers;
+    size_t m_next;
+};
+
+// 运行一轮：producers 个生产者各写入 messages 条消息，一个消费者全部取出。
+// 返回每秒处理的消息数，取出的条数或内容不符时返回负数
+template <typename Transport>
+double run(int producers, long long messages)
+{
+    Transport transport(producers);
+    std::atomic<bool> start(false);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.push_back(std::thread([&transport, &start, p, messages]() {
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (long long i = 0; i < messages; ++i) {
+                // 与 LoggerImpl::enqueue 相同：队列已满时让出 CPU 直到消费者腾出空间
+                while (!transport.tryPush(p, Message(nullptr, i + 1))) {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+
+    const long long total = messages * producers;
+    long long consumed = 0;
+    long long checksum = 0;
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    Message message;
+    while (consumed < total) {
+        if (transport.tryPop(message)) {
+            ++consumed;
+            checksum += message.bytes;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    if (checksum != producers * (messages * (messages + 1) / 2)) {
+        return -1;
+    }
+    const double seconds = std::chrono::duration<double>(end - begin).count();
+    return seconds > 0 ? double(total) / seconds : 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    long long messages = 200000;
+    int maxProducers = 32;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--messages") == 0) {
+            messages = std::atoll(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--max-producers") == 0) {
+            maxProducers = std::atoi(argv[i + 1]);
+        }
+    }
+    if (messages <= 0 || maxProducers <= 0) {
+        std::fprintf(stderr, "usage: %s [--messages N] [--max-producers N]\n", argv[0]);
+        return 2;
+    }
+
+    std::printf("hardware threads: %u, messages per producer: %lld\n",
+                std::thread::hardware_concurrency(), messages);
+    std::printf("%9s %16s %16s %16s\n", "producers", "mutex+deque", "RingBuffer", "SpscRingBuffer");
+    for (int producers = 1; producers <= maxProducers; producers *= 2) {
+        const double mutexRate = run<SharedTransport<MutexQueue> >(producers, messages);
+        const double ringRate = run<SharedTransport<RingBuffer<Message> > >(producers, messages);
+        const double spscRate = run<PerThreadTransport>(producers, messages);
+        if (mutexRate < 0 || ringRate < 0 || spscRate < 0) {
+            std::fprintf(stderr, "lost or corrupted messages with %d producers\n", producers);
+            return 1;
+        }
+        std::printf("%9d %12.2f M/s %12.2f M/s %12.2f M/s\n", producers,
+                    mutexRate / 1e6, ringRate / 1e6, spscRate / 1e6);
+    }
+    return 0;
+}
@@ -1,9 +1,13 @@
 ﻿#include "QsLog.h"
+#include "QsLogArguments.h"
+#include "QsLogCrash.h"
+#include "QsLogJournal.h"
+#include "QsLogRecordPool.h"
+#include "QsLogRingBuffer.h"
+#include "QsLogWakeup.h"
 #include <QDateTime>
 #include <QVector>
 #include <QMutex>
-#include <QThreadPool>
-#include <QQueue>
 #include <QDebug>
 #include <QRunnable>
 #include <QWaitCondition>
@@ -14,13 +18,101 @@
 #include <QFile>
 #include <QTextStream>
 #include <QThread>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+#include <QFutureInterface>
+#include <QStringList>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <limits>
+#if defined(Q_PROCESSOR_X86)
+#include <emmintrin.h>
+#endif
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_UNIX)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#if defined(Q_OS_LINUX)
+#include <sys/syscall.h>
+#endif
+#endif
 
 namespace QsLogging {
 
-// 单例模式的日志器实例指针
-static QsLogging::Logger* s_instance = nullptr;
-// 保护单例实例的互斥锁
+// 单例模式的日志器实例指针，创建完成后以 release 语义发布
+static std::atomic<QsLogging::Logger*> s_instance(nullptr);
+// 保护单例创建与销毁的互斥锁，读取实例时不需要加锁
 static QMutex s_instanceMutex;
+// 单例开始关闭后为 true 且不再复位：此后的日志调用计入丢弃数，不会重新创建单例
+static std::atomic_bool s_shutDown(false);
+
+// 正在使用单例的日志调用数，按线程分散到各自的缓存行上，避免常规路径上的共享计数器竞争。
+// 每个槽位按分组计数：waitForActiveCalls() 切换分组后只等待旧分组归零，之后开始的调用不会让等待延长。
+// 关闭单例、替换持久化日志环之前用它等待已经读取旧状态的调用结束
+struct ActiveCallSlot
+{
+    std::atomic<int> count[2];
+    char padding[CacheLineSize - 2 * sizeof(std::atomic<int>)];
+};
+static const int ActiveCallSlotCount = 64;
+static ActiveCallSlot s_activeCalls[ActiveCallSlotCount];
+static std::atomic<int> s_nextActiveCallSlot(0);
+static std::atomic<unsigned> s_activeCallEpoch(0); // 最低位为当前分组
+static QMutex s_activeCallEpochMutex;              // 同一时刻只进行一次分组切换
+static thread_local int t_activeCallSlot = -1;
+
+// 一次日志调用对单例的使用：构造时登记，关闭已经开始时 entered 为 false，析构时注销
+class ActiveCall
+{
+public:
+    ActiveCall()
+    {
+        if (t_activeCallSlot < 0) {
+            t_activeCallSlot = s_nextActiveCallSlot.fetch_add(1, std::memory_order_relaxed) % ActiveCallSlotCount;
+        }
+        // 登记后确认分组没有在此期间切换，否则在新分组中重新登记。登记与之后读取共享状态之间需要全屏障，
+        // 与 waitForActiveCalls() 的调用方先修改状态、再切换分组并读取计数的顺序相对应
+        for (;;) {
+            const unsigned epoch = s_activeCallEpoch.load(std::memory_order_seq_cst);
+            m_count = &s_activeCalls[t_activeCallSlot].count[epoch & 1];
+            m_count->fetch_add(1, std::memory_order_seq_cst);
+            if (s_activeCallEpoch.load(std::memory_order_seq_cst) == epoch) {
+                break;
+            }
+            m_count->fetch_sub(1, std::memory_order_release);
+        }
+        entered = !s_shutDown.load(std::memory_order_seq_cst);
+    }
+    ~ActiveCall() { m_count->fetch_sub(1, std::memory_order_release); }
+
+    bool entered;
+
+private:
+    ActiveCall(const ActiveCall&);
+    ActiveCall& operator=(const ActiveCall&);
+
+    std::atomic<int>* m_count;
+};
+
+// 等待调用前已经开始的日志调用全部结束。调用方先修改共享状态（关闭标志、日志环指针），
+// 返回后不会再有调用持有修改之前读取的状态
+static void waitForActiveCalls()
+{
+    QMutexLocker locker(&s_activeCallEpochMutex);
+    const unsigned previous = s_activeCallEpoch.fetch_add(1, std::memory_order_seq_cst) & 1;
+    for (const ActiveCallSlot& slot : s_activeCalls) {
+        while (slot.count[previous].load(std::memory_order_seq_cst) != 0) {
+            QThread::yieldCurrentThread();
+        }
+    }
+}
+
+// 当前日志级别，默认级别为 INFO
+std::atomic<int> Logger::s_loggingLevel(InfoLevel);
 
 // 要创建的 HTML 文件的文件名
 const QString HTML_FILENAME = "sqlite_viewer.html";
@@ -641,10 +733,65 @@ const QString HTML_CONTENT = R"(
 // typedef 和 struct
 typedef QVector<DestinationPtr> DestinationList;
 
+// 每个线程私有暂存缓冲区的槽位数，写满时生产者会让出 CPU 等待写入线程腾出空间
+static const size_t ThreadBufferCapacity = 4096;
+// 共享回退队列的槽位数，仅在线程退出阶段使用
+static const size_t SharedQueueCapacity = 4096;
+// 写入线程每轮从单个线程缓冲区最多取出的消息数，保证各线程之间的公平性
+static const int DrainBatchPerThread = 256;
+// 一次交给日志目标的最多记录数，达到后先写出，避免批次无限增长
+static const int MaxWriteBatch = 1024;
+// 默认每分钟汇总一次限流调用点被抑制的次数
+static const int DefaultSuppressionReportInterval = 60000;
+// 默认在关闭时最多用 5 秒写完剩余的日志
+static const int DefaultShutdownTimeout = 5000;
+// 写入线程排空后、休眠前的自旋轮数范围，每轮执行若干次 CPU 暂停指令后检查一次缓冲区。
+// 自旋期间等到了新消息则下次加倍，否则减半：持续有日志时避免反复休眠唤醒，空闲时很快退化为直接休眠
+static const int MinWriterSpinRounds = 2;
+static const int MaxWriterSpinRounds = 256;
+static const int PausesPerSpinRound = 32;
+
+// 自旋等待时提示 CPU 当前处于忙等循环，降低功耗并让出超线程的执行资源
+static inline void cpuRelax()
+{
+#if defined(Q_PROCESSOR_X86)
+    _mm_pause();
+#elif defined(Q_PROCESSOR_ARM) && (defined(Q_CC_GNU) || defined(Q_CC_CLANG))
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// 队列中的一项：日志记录及其计入队列预算的大小
 struct LogMessage {
-    QString message; // 日志消息的文本内容
-    Level level;     // 日志消息的级别（Trace, Debug, Info等）
+    LogMessage() : queuedBytes(0), journal(nullptr), journalPosition(Journal::NoPosition) {}
+
+    LogRecordPtr record; // 日志记录，由写入线程还原内容后交给所有目的地
+    qint64 queuedBytes;  // 计入队列字节预算的大小，0 表示未计入
+    Journal* journal;    // 入队前写入的持久化日志环，未写入时为空
+    quint64 journalPosition; // 记录在日志环中的位置
+};
+
+// 单个日志线程独占的暂存缓冲区，由所属线程写入、写入线程读取
+struct ThreadBuffer
+{
+    ThreadBuffer() : queue(ThreadBufferCapacity), closed(false), discardRequests(0) {}
+
+    SpscRingBuffer<LogMessage> queue; // 单生产者/单消费者队列
+    std::atomic_bool closed;          // 所属线程已退出，排空后即可回收
+    std::atomic<qint64> discardRequests; // DropOldestOnOverflow 策略下缓冲区已满，待写入线程丢弃其队首的次数
+};
+typedef QSharedPointer<ThreadBuffer> ThreadBufferPtr;
+
+// 一次刷新请求：等待请求发出之前入队的所有记录写入并持久化
+struct FlushRequest
+{
+    FlushRequest() : completed(false), result(false) {}
+
+    QFutureInterface<bool> future; // flushAsync() 返回的 QFuture 的完成通知
+    bool completed;                // 是否已完成，由 flushMutex 保护
+    bool result;                   // 所有目的地是否都同步成功，由 flushMutex 保护
 };
+typedef QSharedPointer<FlushRequest> FlushRequestPtr;
 
 // 一个在单独线程中执行的日志写入器
 class LogWriterRunnable : public QRunnable
@@ -655,7 +802,63 @@ public:
     // 重写 run() 方法，这是线程的入口点
     void run() override;
 private:
+    // 外部排空模式下，LoggerImpl 在调用线程上借用写入线程的排空状态（持有 drainMutex）
+    friend class LoggerImpl;
+
+    // 线程缓冲区注册表发生变化时刷新本地快照
+    void refreshBuffers();
+    // 轮询所有缓冲区，把取到的消息合并为一批写出，返回本轮取出的条数
+    int drainPending();
+    // 处理一条取出的消息，批次已满时先写出
+    void collect(LogMessage& message);
+    // 检查是否还有未处理的消息
+    bool hasPending() const;
+    // 排空后短暂自旋等待新消息，等到时返回 true，并据此调整下次的自旋轮数
+    bool spinForMessages();
+    // 没有消息时休眠，直到生产者唤醒、需要汇总抑制次数或切换排空模式。
+    // 调用时持有 drainMutex，休眠期间释放，返回前重新获取
+    void waitForMessages();
+    // 休眠的最长时间（毫秒）：有尚未汇总的抑制或丢弃次数时等到下次汇总，否则一直休眠
+    unsigned long reportWaitTimeout();
+    // 到达汇总间隔时输出限流调用点被抑制的次数，以及因队列溢出丢弃的消息数
+    void reportSuppressed(bool force);
+    // 停止后写完剩余的消息并同步所有目的地，直到写完或超过关闭期限，结果记入 LoggerImpl
+    void drainForShutdown();
+    // 处理刷新请求：取出新请求时记下各缓冲区已入队的位置作为屏障，
+    // 屏障之前的消息全部写出后同步所有目的地，推进已提交序号并完成请求
+    void processFlushRequests();
+    // 处理 DropOldestOnOverflow 策略的丢弃请求：缓冲区已满时丢弃该缓冲区的队首，
+    // 超出队列预算时丢弃所有队首中时间戳最早的一条。返回取出的条数
+    int processDiscardRequests();
+    // 丢弃一条取出的消息；达到同步级别的消息不丢弃，照常写出，同样能腾出空间与预算
+    void discardOrCollect(LogMessage& message);
+    // 调度设置发生变化时在写入线程上应用
+    void applyThreadOptions();
+
     LoggerImpl* m_impl; // 指向 LoggerImpl 实例的指针
+    QElapsedTimer m_reportTimer;        // 距离上次汇总被抑制次数的时间
+    quint64 m_reportedDrops[OffLevel];  // 上次汇总时各级别的丢弃总数
+    QVector<ThreadBufferPtr> m_buffers; // 写入线程持有的缓冲区列表快照
+    int m_buffersVersion;               // 快照对应的注册表版本
+    LogRecordList m_batch;              // 本轮待写出的记录，容量在各轮之间复用
+    int m_spinRounds;                   // 下次休眠前的自旋轮数
+    QVector<FlushRequestPtr> m_flushing; // 已取出、正在等待屏障的刷新请求
+    QVector<QPair<ThreadBufferPtr, size_t> > m_flushBarrier; // 各线程缓冲区在屏障处的入队位置
+    size_t m_sharedFlushBarrier;        // 共享回退队列在屏障处的入队位置
+    int m_threadOptionsVersion;         // 已应用的写入线程调度设置版本
+};
+
+// 运行写入任务的专用线程，使写入线程拥有独立的名称与调度设置
+class LogWriterThread : public QThread
+{
+public:
+    explicit LogWriterThread(LogWriterRunnable* runnable) : m_runnable(runnable) {}
+
+protected:
+    void run() override { m_runnable->run(); }
+
+private:
+    LogWriterRunnable* m_runnable;
 };
 
 // 包含所有日志数据和线程同步机制
@@ -666,77 +869,1197 @@ public:
     ~LoggerImpl();
 
     QVector<DestinationPtr> destinations; // 日志目的地列表，例如文件、控制台等
-    Level logLevel;                   // 当前设置的日志级别
     bool includeTimestamp;            // 是否在日志中包含时间戳
     bool includeLogLevel;             // 是否在日志中包含日志级别
-    QThreadPool threadPool;           // 用于运行日志写入线程的线程池
-    QQueue<LogMessage> messageQueue;  // 待写入的日志消息队列
-    QMutex queueMutex;                // 保护消息队列的互斥锁
+    const quint64 generation;         // 区分先后创建的 LoggerImpl，线程据此判断缓冲区是否过期
+    LogWriterThread* writerThread;    // 运行写入任务的专用线程
+    QVector<ThreadBufferPtr> threadBuffers; // 已注册的线程缓冲区
+    QMutex threadBuffersMutex;        // 保护线程缓冲区注册表，仅在线程首次写日志和回收时使用
+    std::atomic_int threadBuffersVersion; // 注册表每次变化时递增
+    RingBuffer<LogMessage> sharedQueue; // 线程私有缓冲区已销毁时使用的共享回退队列
+    QMutex queueMutex;                // 仅用于写入线程休眠的互斥锁
     QWaitCondition queueWaitCondition; // 用于线程同步的等待条件
+    std::atomic_bool writerWaiting;   // 写入线程是否正在休眠等待新消息
     std::atomic_bool stopSignal;      // 用于向日志写入线程发送停止信号
+    LogWriterRunnable* writer;        // 写入线程的任务对象，在线程退出后销毁
+    QMutex drainMutex;                // 保证同一时刻只有一个线程（写入线程或外部排空的调用方）取出消息
+    std::atomic_bool externalDrain;   // 外部排空模式：写入线程休眠，由调用方在通知句柄可读时排空
+    std::atomic_bool externalWaiting; // 外部排空的调用方已排空并等待通知
+    WakeupNotifier* notifier;         // 外部排空模式的通知句柄，第一次使用时创建
+    quint64 lastSequence;             // 最近分配的记录序号，只由持有 drainMutex 的线程访问
+    std::atomic<quint64> committedSequence; // 已写入并同步到所有目的地的最大序号
+    std::atomic<Journal*> journal;    // 持久化日志环，未启用时为空；日志调用在入队前读取，只由持有 drainMutex 的线程替换
+    QMutex journalMutex;              // 串行化日志环的启用与停用
+    QMutex flushMutex;                // 保护刷新请求列表与请求的完成状态
+    QWaitCondition flushCondition;    // 刷新请求完成时通知
+    QVector<FlushRequestPtr> flushRequests; // 尚未被写入线程取出的刷新请求
+    std::atomic_int pendingFlushes;   // flushRequests 中的请求数，写入线程据此避免加锁检查
+    std::atomic_int suppressionReportInterval; // 汇总限流抑制次数的间隔（毫秒），0 表示不汇总
+    std::atomic_int shutdownTimeout;  // 关闭时写完剩余日志的期限（毫秒），小于 0 表示不限
+    std::atomic_int synchronousLevel; // 达到该级别的日志在调用线程上等待写入并同步，OffLevel 表示全部异步
+    std::atomic_int synchronousTimeout; // 同步写入的最长等待时间（毫秒），小于 0 表示一直等待
+    WriterThreadOptions writerOptions; // 写入线程的调度设置，由 writerOptionsMutex 保护
+    QMutex writerOptionsMutex;
+    std::atomic_int writerOptionsVersion; // 每次修改调度设置时递增，写入线程据此判断是否需要重新应用
+    qint64 shutdownDeadline;          // 本次关闭的截止时刻（单调时钟纳秒），在停止写入线程之前设置
+    ShutdownReport shutdownReport;    // 写入线程退出前填写的关闭结果
+    std::atomic<quint64> latencyCount; // 延迟统计：由写入线程更新，其他线程只读
+    std::atomic<qint64> latencyTotal;
+    std::atomic<qint64> latencyMax;
+    std::atomic_int maxQueuedMessages; // 队列总条数上限，0 表示不限制
+    std::atomic<qint64> maxQueuedBytes; // 队列总字节数上限，0 表示不限制
+    std::atomic<qint64> queuedMessages; // 已计入预算的待写入消息条数
+    std::atomic<qint64> queuedBytes;    // 已计入预算的待写入消息字节数
+    std::atomic_int overflowPolicy;    // OverflowPolicy
+    std::atomic_int overflowBlockTimeout; // 阻塞等待的最长时间（毫秒），小于 0 表示一直等待
+    std::atomic_int overflowDropLevel; // DropBelowLevelOnOverflow 策略下保留的最低级别
+    std::atomic<qint64> discardRequests; // DropOldestOnOverflow 策略下因超出队列预算待写入线程丢弃的消息数
+    std::atomic<qint64> sharedDiscardRequests; // DropOldestOnOverflow 策略下共享回退队列已满，待丢弃其队首的次数
+    std::atomic<quint64> droppedMessages[OffLevel]; // 各级别因溢出被丢弃的消息数
+
+    // 将消息放入当前线程的缓冲区，缓冲区已满时让出 CPU 直到写入线程腾出空间
+    void enqueue(LogMessage&& message);
+    // 入队后调用：只有写入线程正在休眠，或外部排空的调用方正在等待通知时才发出信号
+    void signalWriter();
+    // 无条件唤醒休眠的写入线程
+    void wakeWriter();
+    // 在调用线程上排空所有缓冲区，返回写出的条数；外部排空模式下完成后重新等待通知
+    int drainOnCallerThread();
+    // 获取通知句柄，必要时创建；调用时持有 drainMutex
+    WakeupNotifier* ensureNotifier();
+    // 登记一次刷新请求并通知写入线程
+    FlushRequestPtr requestFlush();
+    // 发出刷新请求并等待完成，见 Logger::flush()
+    bool flush(int timeoutMs);
+    // 以 result 完成并清空 requests 中的刷新请求
+    void completeFlushRequests(QVector<FlushRequestPtr>& requests, bool result);
+    // 推进已提交序号，并记入持久化日志环；调用时持有 drainMutex
+    void commitSequence(quint64 sequence);
+    // 停用并释放当前的持久化日志环：等待写入线程取出所有关联的消息后解除映射，其中的记录标记为无需恢复。
+    // 调用时持有 journalMutex，不能持有 drainMutex；在写入线程上无法等待，返回 false
+    bool retireJournal();
+    // 写入线程取出一条消息后调用：归还字节预算，分配序号、写入日志环并还原内容后加入批次
+    void consume(LogMessage& message, LogRecordList& batch);
+    // 写入线程按 DropOldestOnOverflow 策略丢弃一条取出的消息：归还字节预算并计入丢弃数
+    void discard(LogMessage& message);
+    // 将一批记录交给所有有效的日志目的地，然后清空批次
+    void dispatchBatch(LogRecordList& batch);
+    // 所有缓冲区都已排空时返回 true
+    bool isIdle();
+    // 将记录写入所有有效的日志目的地，必要时先完成延迟格式化
+    void dispatch(LogRecord& record);
+    // 从对象池取出记录并复制内容，供 Logger::Helper 使用。内容复制到记录复用的缓冲区中，
+    // 稳定运行时不分配内存；延迟格式化与结构化的内容由写入线程还原
+    static LogRecordPtr createRecord(Level level, const LogMetadata& metadata, const QChar* text, int size);
+    static LogRecordPtr createDeferredRecord(Level level, const LogMetadata& metadata,
+                                             const char* arguments, int size);
+    static LogRecordPtr createStructuredRecord(Level level, const LogMetadata& metadata,
+                                               const char* fields, int size);
+    // 从注册表中移除已排空的退出线程缓冲区
+    void releaseThreadBuffer(const ThreadBufferPtr& buffer);
+    // 停止写入线程：在期限内写完剩余日志，丢弃超时未写出的消息，可以重复调用
+    ShutdownReport shutdown();
+    // 崩溃转储来源：写出各缓冲区中尚未取出的消息与写入线程手中尚未写出的批次，context 为 LoggerImpl
+    static void dumpPendingRecords(CrashDumpWriter& dumpWriter, void* context);
+
+private:
+    // 获取当前线程的缓冲区，必要时创建并注册；线程正在退出时返回空指针
+    ThreadBuffer* localBuffer();
+    // 判断计入 bytes 后是否超出队列预算
+    bool exceedsQueueLimits(qint64 bytes) const;
+    // 队列已满或超出预算时按溢出策略等待，返回 false 表示应丢弃这条消息
+    bool waitOnOverflow(Level level, QElapsedTimer& timer);
+    // 归还消息占用的预算
+    void releaseQueueBudget(const LogMessage& message);
+    // 请求写入线程丢弃一条最早的消息：requests 为已满的缓冲区的请求计数，超出队列预算时为 discardRequests
+    void requestDiscard(std::atomic<qint64>& requests);
+};
+
+// 每个创建过的 LoggerImpl 的代号，从 1 开始递增
+static std::atomic<quint64> s_loggerGeneration(0);
+
+// 线程局部的缓冲区持有者，线程退出时将缓冲区标记为已关闭，交由写入线程排空回收
+struct ThreadBufferHolder
+{
+    ThreadBufferHolder() : generation(0) {}
+    ~ThreadBufferHolder();
+
+    ThreadBufferPtr buffer;
+    quint64 generation; // 缓冲区注册到的 LoggerImpl 代号
 };
 
+static thread_local ThreadBufferHolder t_threadBuffer;
+// 持有者析构后置位，之后该线程的日志改走共享回退队列
+static thread_local bool t_threadBufferReleased = false;
+// 当前线程正在取出消息并写入目的地（写入线程，或外部排空模式下的调用方），
+// 此时在该线程上等待刷新完成会等待自己
+static thread_local bool t_drainingThread = false;
+
+ThreadBufferHolder::~ThreadBufferHolder()
+{
+    t_threadBufferReleased = true;
+    if (buffer) {
+        buffer->closed.store(true, std::memory_order_release);
+    }
+}
+
+// 每个线程复用的格式化缓冲区，QDebug 始终写入同一个 QString
+struct FormatBuffer
+{
+    FormatBuffer();
+
+    QString text;
+    QDebug debug;
+    QByteArray arguments;    // 延迟格式化模式下的参数记录
+    DeferredStream deferred; // 写入 arguments 的延迟格式化流
+    StructuredStream structured; // 写入 arguments 的结构化日志流
+    bool inUse; // 正在被某个 Helper 使用
+};
+
+// 格式化缓冲区保留的最大容量（字符数/字节数），超长消息结束后释放多余内存
+static const int FormatBufferRetainedCapacity = 4096;
+// 参数记录的初始容量，预留容量后 resize(0) 不会释放内存
+static const int ArgumentsInitialCapacity = 256;
+
+FormatBuffer::FormatBuffer() :
+    debug(&text),
+    deferred(&arguments, &text, &debug),
+    structured(&arguments, &text, &debug),
+    inUse(false)
+{
+    arguments.reserve(ArgumentsInitialCapacity);
+}
+
+// 线程局部的格式化缓冲区持有者
+struct FormatBufferHolder
+{
+    ~FormatBufferHolder();
+
+    FormatBuffer buffer;
+};
+
+static thread_local FormatBufferHolder t_formatBuffer;
+// 持有者析构后置位，之后该线程的日志改用临时缓冲区
+static thread_local bool t_formatBufferReleased = false;
+
+FormatBufferHolder::~FormatBufferHolder()
+{
+    t_formatBufferReleased = true;
+}
+
+// 当前线程的标识和名称
+static quint64 currentThreadIdValue()
+{
+    return static_cast<quint64>(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+}
+
+static QString currentThreadName()
+{
+    QThread* thread = QThread::currentThread();
+    return thread ? thread->objectName() : QString();
+}
+
+// 线程局部的线程信息，在线程第一次写日志时获取，之后每条日志只做拷贝（QString 为隐式共享）
+struct ThreadIdentity
+{
+    ThreadIdentity() : id(currentThreadIdValue()), name(currentThreadName()) {}
+    ~ThreadIdentity();
+
+    quint64 id;
+    QString name;
+};
+
+static thread_local ThreadIdentity t_threadIdentity;
+// 持有者析构后置位，之后该线程的日志每次重新获取线程信息
+static thread_local bool t_threadIdentityReleased = false;
+
+ThreadIdentity::~ThreadIdentity()
+{
+    t_threadIdentityReleased = true;
+}
+
+// 填写日志记录的线程信息
+static void captureThreadIdentity(LogMetadata& metadata)
+{
+    if (!t_threadIdentityReleased) {
+        metadata.threadId = t_threadIdentity.id;
+        metadata.threadName = t_threadIdentity.name;
+    } else {
+        metadata.threadId = currentThreadIdValue();
+        metadata.threadName = currentThreadName();
+    }
+}
+
 // -- LoggerImpl 实现 --
 LoggerImpl::LoggerImpl() :
-    logLevel(InfoLevel),
     includeTimestamp(true),
     includeLogLevel(true),
-    stopSignal(false) // 初始化停止信号为 false
+    generation(++s_loggerGeneration),
+    writerThread(nullptr),
+    threadBuffersVersion(0),
+    sharedQueue(SharedQueueCapacity),
+    writerWaiting(false),
+    stopSignal(false), // 初始化停止信号为 false
+    writer(nullptr),
+    externalDrain(false),
+    externalWaiting(false),
+    notifier(nullptr),
+    lastSequence(0),
+    committedSequence(0),
+    journal(nullptr),
+    pendingFlushes(0),
+    suppressionReportInterval(DefaultSuppressionReportInterval),
+    shutdownTimeout(DefaultShutdownTimeout),
+    synchronousLevel(OffLevel),
+    synchronousTimeout(-1),
+    writerOptionsVersion(0),
+    shutdownDeadline(0),
+    latencyCount(0),
+    latencyTotal(0),
+    latencyMax(0),
+    maxQueuedMessages(0),
+    maxQueuedBytes(0),
+    queuedMessages(0),
+    queuedBytes(0),
+    overflowPolicy(BlockOnOverflow),
+    overflowBlockTimeout(-1),
+    overflowDropLevel(WarnLevel),
+    discardRequests(0),
+    sharedDiscardRequests(0)
 {
-    // 设置线程池最大线程数为 1，确保只有一个日志写入线程在工作
-    threadPool.setMaxThreadCount(1);
-    // 启动日志写入线程
-    threadPool.start(new LogWriterRunnable(this));
+    for (std::atomic<quint64>& dropped : droppedMessages) {
+        dropped.store(0, std::memory_order_relaxed);
+    }
+    // 启动唯一的日志写入线程。Qt 在启动时以 objectName 作为系统中的线程名称
+    writer = new LogWriterRunnable(this);
+    writerThread = new LogWriterThread(writer);
+    writerThread->setObjectName(writerOptions.name);
+    writerThread->start();
+    // 安装了崩溃处理函数时，崩溃前尚未持久化的消息由它转储
+    CrashHandler::addSource(&LoggerImpl::dumpPendingRecords, this);
 }
 
 LoggerImpl::~LoggerImpl()
 {
-    // 在析构函数中设置停止信号为 true
+    shutdown();
+}
+
+ShutdownReport LoggerImpl::shutdown()
+{
+    if (!writer) {
+        // 已经关闭过
+        return shutdownReport;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    const int timeout = shutdownTimeout.load(std::memory_order_relaxed);
+    shutdownDeadline = timeout < 0 ? std::numeric_limits<qint64>::max()
+                                   : Clock::now() + qint64(timeout) * 1000000;
+    // 设置停止信号为 true，写入线程退出主循环后写完剩余的日志
     stopSignal = true;
-    // 唤醒所有等待中的线程（虽然只有一个），以便其能够退出循环
-    queueWaitCondition.wakeAll();
-    // 等待线程池中的所有任务完成，确保日志写入线程已经安全退出
-    threadPool.waitForDone();
-    // 锁定互斥锁，清空消息队列，避免在析构时有消息遗留
+    // 唤醒休眠中的写入线程，以便其能够退出循环
+    wakeWriter();
+    // 等待日志写入线程安全退出
+    writerThread->wait();
+    CrashHandler::removeSource(&LoggerImpl::dumpPendingRecords, this);
+    delete writerThread;
+    writerThread = nullptr;
+    delete writer;
+    writer = nullptr;
+    delete notifier;
+    notifier = nullptr;
+    delete journal.exchange(nullptr, std::memory_order_relaxed);
+    // 写入线程已经退出，尚未处理的刷新请求以失败结束，避免等待者一直阻塞
+    QVector<FlushRequestPtr> unfinished;
+    {
+        QMutexLocker locker(&flushMutex);
+        unfinished.swap(flushRequests);
+    }
+    completeFlushRequests(unfinished, false);
+    // 丢弃超过期限仍留在队列中的消息，释放其占用的字符串
+    LogMessage discarded;
+    while (sharedQueue.tryPop(discarded)) {
+        ++shutdownReport.dropped;
+    }
+    {
+        // 仍在运行的线程持有各自缓冲区的引用，下次写日志时会发现代号不符并重新注册
+        QMutexLocker locker(&threadBuffersMutex);
+        for (const ThreadBufferPtr& buffer : threadBuffers) {
+            while (buffer->queue.tryPop(discarded)) {
+                ++shutdownReport.dropped;
+            }
+        }
+        threadBuffers.clear();
+    }
+    shutdownReport.elapsedMilliseconds = timer.elapsed();
+    return shutdownReport;
+}
+
+ThreadBuffer* LoggerImpl::localBuffer()
+{
+    if (t_threadBufferReleased) {
+        return nullptr;
+    }
+    ThreadBufferHolder& holder = t_threadBuffer;
+    if (!holder.buffer || holder.generation != generation) {
+        // 首次写日志，或上一个 Logger 已被销毁：创建新的缓冲区并登记到注册表
+        holder.buffer = ThreadBufferPtr(new ThreadBuffer);
+        holder.generation = generation;
+        QMutexLocker locker(&threadBuffersMutex);
+        threadBuffers.append(holder.buffer);
+        threadBuffersVersion.fetch_add(1, std::memory_order_release);
+    }
+    return holder.buffer.data();
+}
+
+// 估算消息在队列中占用的字节数
+static qint64 messageBytes(const LogMessage& message)
+{
+    return qint64(sizeof(LogMessage)) + message.record->approximateSize();
+}
+
+bool LoggerImpl::exceedsQueueLimits(qint64 bytes) const
+{
+    const int maxMessages = maxQueuedMessages.load(std::memory_order_relaxed);
+    const qint64 maxBytes = maxQueuedBytes.load(std::memory_order_relaxed);
+    return (maxMessages > 0 && queuedMessages.load(std::memory_order_relaxed) + 1 > maxMessages)
+        || (maxBytes > 0 && queuedBytes.load(std::memory_order_relaxed) + bytes > maxBytes);
+}
+
+bool LoggerImpl::waitOnOverflow(Level level, QElapsedTimer& timer)
+{
+    // 达到同步级别的消息不按丢弃策略丢弃，最多等待同步写入的期限
+    const bool synchronous = static_cast<int>(level) >= synchronousLevel.load(std::memory_order_relaxed);
+    const int policy = overflowPolicy.load(std::memory_order_relaxed);
+    if (!synchronous && policy == DropNewestOnOverflow) {
+        return false;
+    }
+    if (!synchronous && policy == DropBelowLevelOnOverflow
+        && level < overflowDropLevel.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    // 确保写入线程处于工作状态，然后让出时间片
+    signalWriter();
+    const int timeout = synchronous ? synchronousTimeout.load(std::memory_order_relaxed)
+                                    : overflowBlockTimeout.load(std::memory_order_relaxed);
+    if (!timer.isValid()) {
+        timer.start();
+    } else if (timeout >= 0 && timer.elapsed() >= timeout) {
+        return false;
+    }
+    QThread::yieldCurrentThread();
+    return true;
+}
+
+void LoggerImpl::releaseQueueBudget(const LogMessage& message)
+{
+    if (message.queuedBytes > 0) {
+        queuedMessages.fetch_sub(1, std::memory_order_relaxed);
+        queuedBytes.fetch_sub(message.queuedBytes, std::memory_order_relaxed);
+    }
+}
+
+void LoggerImpl::discard(LogMessage& message)
+{
+    releaseQueueBudget(message);
+    if (message.journal) {
+        message.journal->discard(message.journalPosition);
+    }
+    droppedMessages[message.record->level()].fetch_add(1, std::memory_order_relaxed);
+    message.record.clear();
+}
+
+void LoggerImpl::requestDiscard(std::atomic<qint64>& requests)
+{
+    requests.fetch_add(1, std::memory_order_relaxed);
+    signalWriter();
+}
+
+void LoggerImpl::enqueue(LogMessage&& message)
+{
+    const Level level = message.record->level();
+    const bool dropOldest = overflowPolicy.load(std::memory_order_relaxed) == DropOldestOnOverflow;
+    QElapsedTimer waitTimer; // 只在发生溢出时启动
+
+    // 设置了队列预算时才统计条数和字节数，避免常规路径上的共享计数器竞争
+    if (maxQueuedMessages.load(std::memory_order_relaxed) > 0
+        || maxQueuedBytes.load(std::memory_order_relaxed) > 0) {
+        const qint64 bytes = messageBytes(message);
+        while (exceedsQueueLimits(bytes)) {
+            if (dropOldest) {
+                // 由写入线程丢弃最早的一条消息来腾出预算，新消息照常入队
+                requestDiscard(discardRequests);
+                break;
+            }
+            if (!waitOnOverflow(level, waitTimer)) {
+                droppedMessages[level].fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        message.queuedBytes = bytes;
+        queuedMessages.fetch_add(1, std::memory_order_relaxed);
+        queuedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    // 入队之前写入持久化日志环，仍在缓冲区中的记录在进程被杀死后同样可以找回
+    message.journal = journal.load(std::memory_order_acquire);
+    if (message.journal) {
+        message.journalPosition = message.journal->append(*message.record);
+    }
+
+    // 常规路径只访问当前线程独占的缓冲区，线程正在退出时改用共享回退队列
+    ThreadBuffer* buffer = localBuffer();
+    bool discardRequested = false;
+    for (;;) {
+        const bool pushed = buffer ? buffer->queue.tryPush(std::move(message))
+                                   : sharedQueue.tryPush(std::move(message));
+        if (pushed) {
+            break;
+        }
+        if (dropOldest && !discardRequested) {
+            // 丢弃已满的这个缓冲区中最早的消息，才能为新消息腾出槽位
+            requestDiscard(buffer ? buffer->discardRequests : sharedDiscardRequests);
+            discardRequested = true;
+        }
+        if (!waitOnOverflow(level, waitTimer)) {
+            releaseQueueBudget(message);
+            if (message.journal) {
+                message.journal->discard(message.journalPosition);
+            }
+            droppedMessages[level].fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    signalWriter();
+}
+
+void LoggerImpl::signalWriter()
+{
+    // 入队与读取等待标志之间需要全屏障，与写入线程的检查顺序相对应
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // 只由第一个看到等待标志的生产者发出信号，持续写日志时常规路径上只有两次 relaxed 读取
+    if (writerWaiting.load(std::memory_order_relaxed)
+        && writerWaiting.exchange(false, std::memory_order_relaxed)) {
+        wakeWriter();
+    }
+    if (externalWaiting.load(std::memory_order_relaxed)
+        && externalWaiting.exchange(false, std::memory_order_acquire)) {
+        notifier->notify();
+    }
+}
+
+void LoggerImpl::wakeWriter()
+{
+    // 写入线程在持有 queueMutex 时检查缓冲区并进入等待，加锁后唤醒不会错过
     QMutexLocker locker(&queueMutex);
-    messageQueue.clear();
+    queueWaitCondition.wakeAll();
+}
+
+int LoggerImpl::drainOnCallerThread()
+{
+    QMutexLocker locker(&drainMutex);
+    if (!writer) {
+        // 已经关闭
+        return 0;
+    }
+    const bool wasDraining = t_drainingThread;
+    t_drainingThread = true;
+    if (externalDrain.load(std::memory_order_relaxed)) {
+        // 先清除通知再排空，排空期间到达的通知会让句柄再次可读
+        notifier->clear();
+    }
+    int written = 0;
+    for (;;) {
+        int count;
+        while ((count = writer->drainPending()) > 0) {
+            written += count;
+        }
+        writer->processFlushRequests();
+        if (!writer->m_flushing.isEmpty()) {
+            // 屏障之前的消息还在被生产者发布，稍后再检查
+            QThread::yieldCurrentThread();
+            continue;
+        }
+        writer->reportSuppressed(false);
+        if (!externalDrain.load(std::memory_order_relaxed)) {
+            break;
+        }
+        // 设置等待标志后再次检查，避免与生产者的入队操作交错而漏掉通知
+        externalWaiting.store(true, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!writer->hasPending() || !externalWaiting.exchange(false, std::memory_order_relaxed)) {
+            // 没有新消息，或者生产者已经取走标志并发出了通知
+            break;
+        }
+    }
+    t_drainingThread = wasDraining;
+    return written;
+}
+
+WakeupNotifier* LoggerImpl::ensureNotifier()
+{
+    if (!notifier) {
+        notifier = new WakeupNotifier;
+    }
+    return notifier;
+}
+
+FlushRequestPtr LoggerImpl::requestFlush()
+{
+    FlushRequestPtr request(new FlushRequest);
+    request->future.reportStarted();
+    {
+        // 调用方此前的入队操作先于登记请求，写入线程取出请求后读取的入队位置一定包含它们
+        QMutexLocker locker(&flushMutex);
+        flushRequests.append(request);
+        pendingFlushes.fetch_add(1, std::memory_order_relaxed);
+    }
+    signalWriter();
+    return request;
+}
+
+bool LoggerImpl::flush(int timeoutMs)
+{
+    if (t_drainingThread || !writer) {
+        // 在写入线程上（例如日志目的地自己写日志）无法等待，写入线程已停止时请求也不会再被处理
+        return false;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    const FlushRequestPtr request = requestFlush();
+    if (externalDrain.load(std::memory_order_relaxed)) {
+        // 外部排空模式下写入线程在休眠，直接在调用线程上写出并完成请求
+        drainOnCallerThread();
+    }
+    QMutexLocker locker(&flushMutex);
+    while (!request->completed) {
+        if (timeoutMs < 0) {
+            flushCondition.wait(&flushMutex);
+            continue;
+        }
+        const qint64 remaining = timeoutMs - timer.elapsed();
+        if (remaining <= 0) {
+            return false;
+        }
+        flushCondition.wait(&flushMutex, static_cast<unsigned long>(remaining));
+    }
+    return request->result;
+}
+
+void LoggerImpl::completeFlushRequests(QVector<FlushRequestPtr>& requests, bool result)
+{
+    if (requests.isEmpty()) {
+        return;
+    }
+    {
+        QMutexLocker locker(&flushMutex);
+        for (const FlushRequestPtr& request : requests) {
+            request->completed = true;
+            request->result = result;
+            request->future.reportFinished(&result);
+        }
+        flushCondition.wakeAll();
+    }
+    requests.clear();
+}
+
+bool LoggerImpl::isIdle()
+{
+    if (!sharedQueue.isEmpty()) {
+        return false;
+    }
+    QMutexLocker locker(&threadBuffersMutex);
+    for (const ThreadBufferPtr& buffer : threadBuffers) {
+        if (!buffer->queue.isEmpty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LoggerImpl::dispatch(LogRecord& record)
+{
+    record.m_metadata.sequence = ++lastSequence;
+    Journal* activeJournal = journal.load(std::memory_order_relaxed);
+    if (activeJournal) {
+        activeJournal->append(record);
+    }
+    // 延迟格式化和结构化日志在这里还原消息文本和字段，之后记录不再改变
+    record.decode();
+    // 遍历所有日志目的地，每个目的地收到的都是同一条记录
+    for (const auto& dest : destinations) {
+        if (dest && dest->isValid()) {
+            dest->writeRecord(record);
+        }
+    }
+    // 统计从调用点到所有目的地写入完成的延迟
+    const qint64 latency = Clock::now() - record.timestamp();
+    latencyCount.fetch_add(1, std::memory_order_relaxed);
+    latencyTotal.fetch_add(latency, std::memory_order_relaxed);
+    if (latency > latencyMax.load(std::memory_order_relaxed)) {
+        latencyMax.store(latency, std::memory_order_relaxed);
+    }
+}
+
+LogRecordPtr LoggerImpl::createRecord(Level level, const LogMetadata& metadata, const QChar* text, int size)
+{
+    LogRecord* record = RecordPool::instance().acquire();
+    record->m_level = level;
+    record->m_metadata = metadata;
+    record->m_message.append(text, size);
+    return LogRecordPtr(record);
+}
+
+LogRecordPtr LoggerImpl::createDeferredRecord(Level level, const LogMetadata& metadata,
+                                              const char* arguments, int size)
+{
+    LogRecord* record = RecordPool::instance().acquire();
+    record->m_level = level;
+    record->m_metadata = metadata;
+    record->m_encoding = LogRecord::DeferredArguments;
+    record->m_payload.append(arguments, size);
+    return LogRecordPtr(record);
+}
+
+LogRecordPtr LoggerImpl::createStructuredRecord(Level level, const LogMetadata& metadata,
+                                                const char* fields, int size)
+{
+    LogRecord* record = RecordPool::instance().acquire();
+    record->m_level = level;
+    record->m_metadata = metadata;
+    record->m_encoding = LogRecord::StructuredFields;
+    record->m_payload.append(fields, size);
+    return LogRecordPtr(record);
+}
+
+void LoggerImpl::dispatchBatch(LogRecordList& batch)
+{
+    if (batch.isEmpty()) {
+        return;
+    }
+    // 每个目的地每批只检查一次有效性、调用一次虚函数
+    for (const auto& dest : destinations) {
+        if (dest && dest->isValid()) {
+            dest->writeBatch(batch);
+        }
+    }
+    // 统计从调用点到所有目的地写入完成的延迟
+    const qint64 now = Clock::now();
+    qint64 total = 0;
+    qint64 maximum = latencyMax.load(std::memory_order_relaxed);
+    for (const LogRecordPtr& record : batch) {
+        const qint64 latency = now - record->timestamp();
+        total += latency;
+        maximum = qMax(maximum, latency);
+    }
+    latencyCount.fetch_add(batch.size(), std::memory_order_relaxed);
+    latencyTotal.fetch_add(total, std::memory_order_relaxed);
+    latencyMax.store(maximum, std::memory_order_relaxed);
+    batch.clear();
+}
+
+void LoggerImpl::consume(LogMessage& message, LogRecordList& batch)
+{
+    releaseQueueBudget(message);
+    // 分配序号并补写到入队前写入的持久化日志环中，再还原内容加入批次，之后记录不再改变
+    LogRecord* record = message.record.mutableData();
+    record->m_metadata.sequence = ++lastSequence;
+    if (message.journal) {
+        message.journal->setSequence(message.journalPosition, lastSequence);
+    }
+    record->decode();
+    batch.append(std::move(message.record));
+}
+
+void LoggerImpl::commitSequence(quint64 sequence)
+{
+    committedSequence.store(sequence, std::memory_order_release);
+    Journal* activeJournal = journal.load(std::memory_order_relaxed);
+    if (activeJournal) {
+        activeJournal->setCommittedSequence(sequence);
+    }
+}
+
+bool LoggerImpl::retireJournal()
+{
+    if (t_drainingThread) {
+        qWarning() << "QsLog: The journal cannot be replaced on the log writer thread";
+        return false;
+    }
+    Journal* retired = journal.exchange(nullptr, std::memory_order_acq_rel);
+    if (!retired) {
+        return true;
+    }
+    // 已经读取旧日志环的日志调用先完成入队，随后由写入线程取出这些消息、补写序号或作废记录，
+    // 之后没有消息再引用旧日志环，可以解除映射；同一文件随后可以安全地重新启用
+    waitForActiveCalls();
+    flush(-1);
+    {
+        QMutexLocker locker(&drainMutex);
+        retired->markRecovered();
+        delete retired;
+    }
+    return true;
+}
+
+void LoggerImpl::dumpPendingRecords(CrashDumpWriter& dumpWriter, void* context)
+{
+    // 运行在崩溃处理函数中：只读取，不加锁，不分配内存（const 访问不会触发隐式共享的分离）
+    const LoggerImpl* impl = static_cast<const LoggerImpl*>(context);
+    auto dumpMessage = [&dumpWriter](const LogMessage& message) {
+        if (message.record) {
+            dumpWriter.write(*message.record);
+        }
+    };
+    // 写入线程已取出、尚未交给目的地的批次排在队列中的消息之前；
+    // 关闭阶段写入线程对象随时可能被销毁，此时只转储队列
+    if (impl->writer && !impl->stopSignal.load(std::memory_order_relaxed)) {
+        const LogRecordList& batch = impl->writer->m_batch;
+        for (const LogRecordPtr& record : batch) {
+            dumpWriter.write(*record);
+        }
+    }
+    const QVector<ThreadBufferPtr>& buffers = impl->threadBuffers;
+    for (const ThreadBufferPtr& buffer : buffers) {
+        buffer->queue.peek(dumpMessage);
+    }
+    impl->sharedQueue.peek(dumpMessage);
+}
+
+void LoggerImpl::releaseThreadBuffer(const ThreadBufferPtr& buffer)
+{
+    QMutexLocker locker(&threadBuffersMutex);
+    threadBuffers.removeOne(buffer);
+    threadBuffersVersion.fetch_add(1, std::memory_order_release);
 }
 
 // -- LogWriterRunnable 实现 --
-LogWriterRunnable::LogWriterRunnable(LoggerImpl* impl) : m_impl(impl)
+LogWriterRunnable::LogWriterRunnable(LoggerImpl* impl) :
+    m_impl(impl),
+    m_buffersVersion(-1),
+    m_spinRounds(MinWriterSpinRounds),
+    m_sharedFlushBarrier(0),
+    m_threadOptionsVersion(0)
 {
-    // 确保 QRunnable 在任务完成后自动销毁
-    setAutoDelete(true);
+    for (quint64& reported : m_reportedDrops) {
+        reported = 0;
+    }
+    m_batch.reserve(MaxWriteBatch);
+    // 由 LoggerImpl 在写入线程退出后销毁
+    setAutoDelete(false);
 }
 
 void LogWriterRunnable::run()
 {
+    m_reportTimer.start();
+    t_drainingThread = true;
+    // 取出消息期间一直持有 drainMutex，只在休眠时释放
+    m_impl->drainMutex.lock();
     // 线程主循环，只要停止信号为 false 就一直运行
     while (!m_impl->stopSignal) {
-        // 锁定互斥锁，访问共享的消息队列
-        m_impl->queueMutex.lock();
-        // 如果消息队列为空，则进入等待状态
-        if (m_impl->messageQueue.isEmpty()) {
-            // 等待直到有新消息或超时（100毫秒）
-            m_impl->queueWaitCondition.wait(&m_impl->queueMutex, 100);
-        }
-        // 再次检查队列是否为空（可能因超时而唤醒），如果为空则继续下一次循环
-        if (m_impl->messageQueue.isEmpty()) {
-            m_impl->queueMutex.unlock();
+        if (m_impl->writerOptionsVersion.load(std::memory_order_acquire) != m_threadOptionsVersion) {
+            applyThreadOptions();
+        }
+        if (m_impl->externalDrain.load(std::memory_order_relaxed)) {
+            waitForMessages();
             continue;
         }
+        const int drained = drainPending();
+        processFlushRequests();
+        if (drained == 0 && !m_flushing.isEmpty()) {
+            // 屏障之前的消息还在被生产者发布，稍后再检查
+            QThread::yieldCurrentThread();
+        } else if (drained == 0 && !spinForMessages()) {
+            waitForMessages();
+        }
+        reportSuppressed(false);
+    }
+    drainForShutdown();
+    // 写入线程退出后不会再处理已取出的刷新请求
+    m_impl->completeFlushRequests(m_flushing, false);
+    m_impl->drainMutex.unlock();
+    t_drainingThread = false;
+}
+
+void LogWriterRunnable::drainForShutdown()
+{
+    ShutdownReport& report = m_impl->shutdownReport;
+    for (;;) {
+        const int count = drainPending();
+        report.written += count;
+        // 关闭期间发出的刷新请求同样可以完成
+        processFlushRequests();
+        if (count == 0 && m_flushing.isEmpty() && !hasPending()) {
+            break;
+        }
+        if (Clock::now() >= m_impl->shutdownDeadline) {
+            report.timedOut = true;
+            break;
+        }
+        if (count == 0) {
+            QThread::yieldCurrentThread();
+        }
+    }
+    // 汇总最后一个周期内被抑制的次数
+    reportSuppressed(true);
+    // 最后同步一次，使写出的记录全部持久化
+    for (const auto& dest : m_impl->destinations) {
+        if (dest && dest->isValid()) {
+            report.synced = dest->sync() && report.synced;
+        }
+    }
+    if (report.synced) {
+        m_impl->commitSequence(m_impl->lastSequence);
+    }
+}
+
+void LogWriterRunnable::refreshBuffers()
+{
+    const int version = m_impl->threadBuffersVersion.load(std::memory_order_acquire);
+    if (version == m_buffersVersion) {
+        return;
+    }
+    QMutexLocker locker(&m_impl->threadBuffersMutex);
+    m_buffers = m_impl->threadBuffers;
+    m_buffersVersion = m_impl->threadBuffersVersion.load(std::memory_order_relaxed);
+}
 
-        // 从队列中取出一条消息
-        LogMessage message = m_impl->messageQueue.dequeue();
-        // 解锁互斥锁，让其他线程可以继续向队列添加消息
-        m_impl->queueMutex.unlock();
+int LogWriterRunnable::drainPending()
+{
+    refreshBuffers();
+
+    int written = processDiscardRequests();
+    LogMessage message;
+    // 共享回退队列中只有线程退出阶段的少量消息，直接全部取出
+    while (m_impl->sharedQueue.tryPop(message)) {
+        collect(message);
+        ++written;
+    }
+    // 轮流处理每个线程的缓冲区
+    for (const ThreadBufferPtr& buffer : m_buffers) {
+        // 先读取关闭标志再排空，确保排空后不会再有新消息写入
+        const bool closed = buffer->closed.load(std::memory_order_acquire);
+        int count = 0;
+        while (count < DrainBatchPerThread && buffer->queue.tryPop(message)) {
+            collect(message);
+            ++count;
+        }
+        written += count;
+        if (closed && buffer->queue.isEmpty()) {
+            // 所属线程已退出且消息已全部写出，回收该缓冲区
+            m_impl->releaseThreadBuffer(buffer);
+        }
+    }
+    // 本轮取到的消息作为一批写出
+    m_impl->dispatchBatch(m_batch);
+    return written;
+}
 
-        // 遍历所有日志目的地，并将消息写入
-        for (const auto& dest : m_impl->destinations) {
-            if (dest && dest->isValid()) {
-                dest->write(message.message, message.level);
+void LogWriterRunnable::collect(LogMessage& message)
+{
+    m_impl->consume(message, m_batch);
+    if (m_batch.size() >= MaxWriteBatch) {
+        m_impl->dispatchBatch(m_batch);
+    }
+}
+
+int LogWriterRunnable::processDiscardRequests()
+{
+    int taken = 0;
+    LogMessage message;
+    // 已满的缓冲区：其队首就是该缓冲区中最早的消息。请求发出后缓冲区可能已被排空，多余的请求直接作废
+    for (const ThreadBufferPtr& buffer : m_buffers) {
+        if (buffer->discardRequests.load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        for (qint64 requests = buffer->discardRequests.exchange(0, std::memory_order_relaxed);
+             requests > 0 && buffer->queue.tryPop(message); --requests) {
+            discardOrCollect(message);
+            ++taken;
+        }
+    }
+    if (m_impl->sharedDiscardRequests.load(std::memory_order_relaxed) > 0) {
+        for (qint64 requests = m_impl->sharedDiscardRequests.exchange(0, std::memory_order_relaxed);
+             requests > 0 && m_impl->sharedQueue.tryPop(message); --requests) {
+            discardOrCollect(message);
+            ++taken;
+        }
+    }
+    // 超出队列预算：各队列按入队顺序出队，最早的消息一定是某个队首，比较队首的时间戳
+    if (m_impl->discardRequests.load(std::memory_order_relaxed) > 0) {
+        for (qint64 requests = m_impl->discardRequests.exchange(0, std::memory_order_relaxed); requests > 0;
+             --requests) {
+            const LogMessage* oldest = m_impl->sharedQueue.front();
+            SpscRingBuffer<LogMessage>* oldestQueue = nullptr;
+            for (const ThreadBufferPtr& buffer : m_buffers) {
+                const LogMessage* head = buffer->queue.front();
+                if (head && (!oldest || head->record->timestamp() < oldest->record->timestamp())) {
+                    oldest = head;
+                    oldestQueue = &buffer->queue;
+                }
             }
+            if (!oldest) {
+                // 队列已经排空，预算已随写出归还
+                break;
+            }
+            if (oldestQueue) {
+                oldestQueue->tryPop(message);
+            } else {
+                m_impl->sharedQueue.tryPop(message);
+            }
+            discardOrCollect(message);
+            ++taken;
+        }
+    }
+    return taken;
+}
+
+void LogWriterRunnable::discardOrCollect(LogMessage& message)
+{
+    const Level level = message.record->level();
+    if (static_cast<int>(level) >= m_impl->synchronousLevel.load(std::memory_order_relaxed)) {
+        // 调用线程可能正在等待它写入并同步
+        collect(message);
+        return;
+    }
+    m_impl->discard(message);
+}
+
+bool LogWriterRunnable::hasPending() const
+{
+    if (!m_impl->sharedQueue.isEmpty() || m_impl->pendingFlushes.load(std::memory_order_relaxed) > 0) {
+        return true;
+    }
+    if (m_impl->threadBuffersVersion.load(std::memory_order_acquire) != m_buffersVersion) {
+        // 有新线程注册了缓冲区，需要重新轮询
+        return true;
+    }
+    for (const ThreadBufferPtr& buffer : m_buffers) {
+        if (!buffer->queue.isEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LogWriterRunnable::processFlushRequests()
+{
+    if (m_flushing.isEmpty()) {
+        if (m_impl->pendingFlushes.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        {
+            QMutexLocker locker(&m_impl->flushMutex);
+            m_flushing.swap(m_impl->flushRequests);
+            m_impl->pendingFlushes.store(0, std::memory_order_relaxed);
         }
+        // 取出请求之后再读取入队位置，请求发出之前入队的消息都在屏障之内
+        refreshBuffers();
+        m_flushBarrier.clear();
+        for (const ThreadBufferPtr& buffer : m_buffers) {
+            m_flushBarrier.append(qMakePair(buffer, buffer->queue.pushedCount()));
+        }
+        m_sharedFlushBarrier = m_impl->sharedQueue.pushedCount();
+    }
+    if (m_impl->sharedQueue.poppedCount() < m_sharedFlushBarrier) {
+        return;
+    }
+    for (const QPair<ThreadBufferPtr, size_t>& barrier : m_flushBarrier) {
+        if (barrier.first->queue.poppedCount() < barrier.second) {
+            return;
+        }
+    }
+    // 取出的消息在 drainPending() 返回前已经写出，同步所有目的地后屏障之前的记录即已持久化
+    bool synced = true;
+    for (const auto& dest : m_impl->destinations) {
+        if (dest && dest->isValid()) {
+            synced = dest->sync() && synced;
+        }
+    }
+    if (synced) {
+        m_impl->commitSequence(m_impl->lastSequence);
+    }
+    m_flushBarrier.clear();
+    m_impl->completeFlushRequests(m_flushing, synced);
+}
+
+bool LogWriterRunnable::spinForMessages()
+{
+    for (int round = 0; round < m_spinRounds; ++round) {
+        for (int i = 0; i < PausesPerSpinRound; ++i) {
+            cpuRelax();
+        }
+        if (hasPending()) {
+            // 自旋期间等到了新消息，说明日志仍在持续产生，下次多自旋一会
+            m_spinRounds = qMin(m_spinRounds * 2, MaxWriterSpinRounds);
+            return true;
+        }
+    }
+    m_spinRounds = qMax(m_spinRounds / 2, MinWriterSpinRounds);
+    return false;
+}
+
+void LogWriterRunnable::waitForMessages()
+{
+    m_impl->queueMutex.lock();
+    if (m_impl->externalDrain.load(std::memory_order_relaxed)) {
+        // 由外部事件循环排空，写入线程休眠到切换回内部排空或停止
+        m_impl->drainMutex.unlock();
+        while (m_impl->externalDrain.load(std::memory_order_relaxed) && !m_impl->stopSignal
+               && m_impl->writerOptionsVersion.load(std::memory_order_relaxed) == m_threadOptionsVersion) {
+            m_impl->queueWaitCondition.wait(&m_impl->queueMutex);
+        }
+    } else {
+        m_impl->writerWaiting.store(true, std::memory_order_relaxed);
+        // 设置等待标志后再次检查，避免与生产者的入队操作交错而漏掉消息
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const bool pending = hasPending();
+        const unsigned long timeout = reportWaitTimeout();
+        // 检查缓冲区需要持有 drainMutex，休眠前释放，让外部排空的调用方不必等待
+        m_impl->drainMutex.unlock();
+        if (!pending && !m_impl->stopSignal
+            && m_impl->writerOptionsVersion.load(std::memory_order_relaxed) == m_threadOptionsVersion) {
+            m_impl->queueWaitCondition.wait(&m_impl->queueMutex, timeout);
+        }
+        m_impl->writerWaiting.store(false, std::memory_order_relaxed);
+    }
+    // 按 drainMutex -> queueMutex 的顺序加锁，先释放 queueMutex 再重新获取 drainMutex
+    m_impl->queueMutex.unlock();
+    m_impl->drainMutex.lock();
+}
+
+void LogWriterRunnable::applyThreadOptions()
+{
+    WriterThreadOptions options;
+    {
+        QMutexLocker locker(&m_impl->writerOptionsMutex);
+        options = m_impl->writerOptions;
+        m_threadOptionsVersion = m_impl->writerOptionsVersion.load(std::memory_order_relaxed);
+    }
+    QThread* thread = QThread::currentThread();
+    if (!options.name.isEmpty() && options.name != thread->objectName()) {
+        thread->setObjectName(options.name);
+        // Qt 只在线程启动时设置系统中的线程名称
+#if defined(Q_OS_LINUX)
+        // 内核限制线程名称为 15 字节
+        pthread_setname_np(pthread_self(), options.name.toUtf8().left(15).constData());
+#elif defined(Q_OS_MAC)
+        pthread_setname_np(options.name.toUtf8().constData());
+#endif
+    }
+    if (options.priority != QThread::InheritPriority) {
+        thread->setPriority(options.priority);
+    }
+    if (options.niceValue != 0) {
+#if defined(Q_OS_LINUX)
+        // Linux 上 nice 值按线程生效，以线程 ID 作为 PRIO_PROCESS 的对象只影响写入线程
+        const id_t tid = static_cast<id_t>(syscall(SYS_gettid));
+        if (setpriority(PRIO_PROCESS, tid, options.niceValue) != 0) {
+            qWarning() << "QsLog: Failed to set writer thread nice value" << options.niceValue << errno;
+        }
+#else
+        qWarning() << "QsLog: Per-thread nice values are not supported on this platform";
+#endif
+    }
+    if (options.cpuAffinityMask != 0) {
+#if defined(Q_OS_LINUX)
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+            if (options.cpuAffinityMask & (quint64(1) << cpu)) {
+                CPU_SET(cpu, &cpus);
+            }
+        }
+        const int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (error != 0) {
+            qWarning() << "QsLog: Failed to set writer thread CPU affinity" << QString::number(options.cpuAffinityMask, 16) << error;
+        }
+#elif defined(Q_OS_WIN)
+        if (SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(options.cpuAffinityMask)) == 0) {
+            qWarning() << "QsLog: Failed to set writer thread CPU affinity" << QString::number(options.cpuAffinityMask, 16) << GetLastError();
+        }
+#else
+        qWarning() << "QsLog: Writer thread CPU affinity is not supported on this platform";
+#endif
+    }
+}
+
+unsigned long LogWriterRunnable::reportWaitTimeout()
+{
+    const int interval = m_impl->suppressionReportInterval.load(std::memory_order_relaxed);
+    if (interval <= 0) {
+        return ULONG_MAX;
+    }
+    bool unreported = false;
+    for (int level = 0; level < OffLevel && !unreported; ++level) {
+        unreported = m_impl->droppedMessages[level].load(std::memory_order_relaxed) != m_reportedDrops[level];
+    }
+    if (!unreported) {
+        for (const LogSite* site : LogSiteRegistry::sites()) {
+            if ((site->flags & LogSite::RateLimited) && site->suppressed.load(std::memory_order_relaxed) > 0) {
+                unreported = true;
+                break;
+            }
+        }
+    }
+    if (!unreported) {
+        // 休眠期间才被抑制的次数在下一条日志唤醒写入线程时汇总
+        return ULONG_MAX;
+    }
+    return static_cast<unsigned long>(qMax<qint64>(interval - m_reportTimer.elapsed(), 1));
+}
+
+void LogWriterRunnable::reportSuppressed(bool force)
+{
+    const int interval = m_impl->suppressionReportInterval.load(std::memory_order_relaxed);
+    if (interval <= 0 || (!force && m_reportTimer.elapsed() < interval)) {
+        return;
+    }
+    const qint64 elapsed = m_reportTimer.restart();
+    for (const LogSite* site : LogSiteRegistry::sites()) {
+        if (!(site->flags & LogSite::RateLimited)) {
+            continue;
+        }
+        const quint64 count = site->suppressed.exchange(0, std::memory_order_relaxed);
+        if (count == 0) {
+            continue;
+        }
+        // 汇总消息不关联调用点，避免被当作该调用点的一次正常输出
+        LogMetadata metadata;
+        metadata.timestamp = Clock::now();
+        LogRecord record(site->level, metadata,
+                         QString("QsLog: suppressed %1 message(s) from %2@%3 (%4) in the last %5 ms")
+                             .arg(count)
+                             .arg(QString::fromUtf8(site->file))
+                             .arg(site->line)
+                             .arg(QString::fromUtf8(site->function))
+                             .arg(elapsed));
+        m_impl->dispatch(record);
+    }
+
+    // 汇总本周期内因队列溢出丢弃的消息
+    quint64 dropped = 0;
+    QStringList perLevel;
+    static const char* const levelNames[OffLevel] = { "trace", "debug", "info", "warn", "error", "fatal" };
+    for (int level = 0; level < OffLevel; ++level) {
+        const quint64 total = m_impl->droppedMessages[level].load(std::memory_order_relaxed);
+        // 计数被重置后从头统计
+        const quint64 delta = total >= m_reportedDrops[level] ? total - m_reportedDrops[level] : total;
+        m_reportedDrops[level] = total;
+        if (delta > 0) {
+            dropped += delta;
+            perLevel << QString("%1 %2").arg(QLatin1String(levelNames[level])).arg(delta);
+        }
+    }
+    if (dropped > 0) {
+        LogMetadata metadata;
+        metadata.timestamp = Clock::now();
+        LogRecord record(WarnLevel, metadata,
+                         QString("QsLog: dropped %1 message(s) on queue overflow in the last %2 ms (%3)")
+                             .arg(dropped)
+                             .arg(elapsed)
+                             .arg(perLevel.join(", ")));
+        m_impl->dispatch(record);
     }
 }
 
@@ -762,35 +2085,94 @@ void createHtmlFile() {
 }
 
 
+// 进程退出时销毁单例，写完剩余的日志
+static void destroyInstanceAtExit()
+{
+    Logger::destroyInstance();
+}
+
+// 应用程序即将退出事件循环时写完已有的日志，此时 Qt 的各个模块仍然可用
+static void flushOnAboutToQuit()
+{
+    Logger* logger = s_instance.load(std::memory_order_acquire);
+    if (logger) {
+        logger->flush(logger->shutdownTimeout());
+    }
+}
+
+// 登记退出钩子，调用时持有 s_instanceMutex
+static void installShutdownHooks()
+{
+    static bool exitHookInstalled = false;
+    if (!exitHookInstalled) {
+        std::atexit(destroyInstanceAtExit);
+        exitHookInstalled = true;
+    }
+    // 单例可能在 QCoreApplication 创建之前或销毁之后创建，每个应用程序对象只连接一次
+    static QCoreApplication* hookedApplication = nullptr;
+    QCoreApplication* application = QCoreApplication::instance();
+    if (application && application != hookedApplication) {
+        QObject::connect(application, &QCoreApplication::aboutToQuit, &flushOnAboutToQuit);
+        hookedApplication = application;
+    }
+}
+
 // 获取 Logger 实例的单例方法
 Logger& Logger::instance()
 {
-    // 锁定互斥锁以确保线程安全
+    // 快速路径：实例已经发布，直接返回
+    Logger* logger = s_instance.load(std::memory_order_acquire);
+    if (logger) {
+        return *logger;
+    }
+    // 慢速路径：锁定互斥锁，确保只有一个线程创建实例
     QMutexLocker locker(&s_instanceMutex);
-    if (!s_instance) {
+    logger = s_instance.load(std::memory_order_relaxed);
+    if (!logger) {
         // 如果实例不存在，则先创建 HTML 文件
         createHtmlFile();
-        // 然后创建新的 Logger 实例
-        s_instance = new Logger;
+        // 然后创建新的 Logger 实例并发布
+        logger = new Logger;
+        s_instance.store(logger, std::memory_order_release);
+        // 退出时自动写完剩余的日志，不必手动调用 destroyInstance()
+        installShutdownHooks();
     }
     // 返回单例引用
-    return *s_instance;
+    return *logger;
 }
 
 // 销毁 Logger 实例的单例方法
-void Logger::destroyInstance()
+ShutdownReport Logger::destroyInstance()
 {
-    // 锁定互斥锁
-    QMutexLocker locker(&s_instanceMutex);
-    if (s_instance) {
-        // 删除实例并将其指针置空
-        delete s_instance;
-        s_instance = nullptr;
+    Logger* logger;
+    {
+        // 锁定互斥锁，进入终止状态：此后的日志调用不再进入单例，也不会重新创建它
+        QMutexLocker locker(&s_instanceMutex);
+        logger = s_instance.load(std::memory_order_relaxed);
+        if (!logger || s_shutDown.load(std::memory_order_relaxed)) {
+            return ShutdownReport();
+        }
+        s_shutDown.store(true, std::memory_order_seq_cst);
     }
+    // 在锁外等待已经取得单例的日志调用入队完成，它们的记录随后一起写出
+    waitForActiveCalls();
+    const ShutdownReport report = logger->d->shutdown();
+    // 单例保留到进程结束，仍持有它的调用方不会访问已释放的内存；
+    // 日志目的地在这里释放，使其析构时关闭文件与数据库连接
+    logger->d->destinations.clear();
+    if (report.dropped > 0 || report.timedOut || !report.synced) {
+        qWarning() << "QsLog: shutdown wrote" << report.written << "record(s), dropped" << report.dropped
+                   << "after" << report.elapsedMilliseconds << "ms" << (report.synced ? "" : "(sync failed)");
+    }
+    return report;
 }
 
-// Logger 构造函数
-Logger::Logger() : d(new LoggerImpl) {}
+// Logger 构造函数，新实例从默认级别开始
+Logger::Logger() : d(new LoggerImpl)
+{
+    s_loggingLevel.store(InfoLevel, std::memory_order_relaxed);
+    Category::setDefaultLevel(InfoLevel);
+}
 
 // Logger 析构函数
 Logger::~Logger()
@@ -809,13 +2191,15 @@ void Logger::addDestination(DestinationPtr destination)
 // 设置日志级别
 void Logger::setLoggingLevel(Level newLevel)
 {
-    d->logLevel = newLevel;
+    s_loggingLevel.store(newLevel, std::memory_order_relaxed);
+    // 没有匹配规则的类别跟随全局级别
+    Category::setDefaultLevel(newLevel);
 }
 
 // 获取当前日志级别
 Level Logger::loggingLevel() const
 {
-    return d->logLevel;
+    return static_cast<Level>(s_loggingLevel.load(std::memory_order_relaxed));
 }
 
 // 设置是否包含时间戳
@@ -842,46 +2226,344 @@ bool Logger::includeLogLevel() const
     return d->includeLogLevel;
 }
 
+// 设置队列总条数和总字节数上限
+void Logger::setQueueLimits(int maxMessages, qint64 maxBytes)
+{
+    d->maxQueuedMessages.store(qMax(0, maxMessages), std::memory_order_relaxed);
+    d->maxQueuedBytes.store(qMax(qint64(0), maxBytes), std::memory_order_relaxed);
+}
+
+// 设置溢出策略
+void Logger::setOverflowPolicy(OverflowPolicy policy, int blockTimeoutMs, Level dropBelowLevel)
+{
+    d->overflowBlockTimeout.store(blockTimeoutMs, std::memory_order_relaxed);
+    d->overflowDropLevel.store(dropBelowLevel, std::memory_order_relaxed);
+    d->overflowPolicy.store(policy, std::memory_order_relaxed);
+}
+
+// 获取当前的溢出策略
+OverflowPolicy Logger::overflowPolicy() const
+{
+    return static_cast<OverflowPolicy>(d->overflowPolicy.load(std::memory_order_relaxed));
+}
+
+// 获取指定级别因队列溢出而丢弃的消息数
+quint64 Logger::droppedMessageCount(Level level) const
+{
+    if (level < TraceLevel || level >= OffLevel) {
+        return 0;
+    }
+    return d->droppedMessages[level].load(std::memory_order_relaxed);
+}
+
+// 重置丢弃计数
+void Logger::resetDroppedMessageCounts()
+{
+    for (std::atomic<quint64>& dropped : d->droppedMessages) {
+        dropped.store(0, std::memory_order_relaxed);
+    }
+}
+
+// 获取端到端写入延迟统计
+LatencyStatistics Logger::latencyStatistics() const
+{
+    LatencyStatistics statistics;
+    statistics.count = d->latencyCount.load(std::memory_order_relaxed);
+    statistics.totalNanoseconds = d->latencyTotal.load(std::memory_order_relaxed);
+    statistics.maxNanoseconds = d->latencyMax.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+// 重置延迟统计
+void Logger::resetLatencyStatistics()
+{
+    d->latencyCount.store(0, std::memory_order_relaxed);
+    d->latencyTotal.store(0, std::memory_order_relaxed);
+    d->latencyMax.store(0, std::memory_order_relaxed);
+}
+
+// 设置限流日志宏汇总被抑制次数的间隔
+void Logger::setSuppressionReportInterval(int msecs)
+{
+    d->suppressionReportInterval.store(msecs, std::memory_order_relaxed);
+    // 写入线程可能正按旧的间隔休眠
+    d->wakeWriter();
+}
+
+// 获取汇总间隔
+int Logger::suppressionReportInterval() const
+{
+    return d->suppressionReportInterval.load(std::memory_order_relaxed);
+}
+
+// 设置关闭时写完剩余日志的期限
+void Logger::setShutdownTimeout(int msecs)
+{
+    d->shutdownTimeout.store(msecs, std::memory_order_relaxed);
+}
+
+// 获取关闭期限
+int Logger::shutdownTimeout() const
+{
+    return d->shutdownTimeout.load(std::memory_order_relaxed);
+}
+
+// 设置同步写入的级别
+void Logger::setSynchronousLevel(Level level, int timeoutMs)
+{
+    d->synchronousTimeout.store(timeoutMs, std::memory_order_relaxed);
+    d->synchronousLevel.store(level, std::memory_order_relaxed);
+}
+
+// 获取同步写入的级别
+Level Logger::synchronousLevel() const
+{
+    return static_cast<Level>(d->synchronousLevel.load(std::memory_order_relaxed));
+}
+
+// 切换外部排空模式
+bool Logger::setExternalDrainEnabled(bool enabled)
+{
+    {
+        // 持有 drainMutex 时写入线程不在取消息，切换后它在下一轮循环中进入对应的休眠方式
+        QMutexLocker locker(&d->drainMutex);
+        if (enabled == d->externalDrain.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        if (enabled) {
+            if (!d->ensureNotifier()->isValid()) {
+                return false;
+            }
+            d->externalDrain.store(true, std::memory_order_relaxed);
+            // 让事件循环先排空一次，之后由 processPendingMessages() 重新等待通知
+            d->notifier->notify();
+        } else {
+            d->externalDrain.store(false, std::memory_order_relaxed);
+            d->externalWaiting.store(false, std::memory_order_relaxed);
+        }
+    }
+    // 写入线程在两种模式下都可能处于休眠
+    d->wakeWriter();
+    return true;
+}
+
+// 是否处于外部排空模式
+bool Logger::externalDrainEnabled() const
+{
+    return d->externalDrain.load(std::memory_order_relaxed);
+}
+
+// 获取外部排空模式的通知句柄
+qintptr Logger::notificationHandle()
+{
+    QMutexLocker locker(&d->drainMutex);
+    return d->ensureNotifier()->handle();
+}
+
+// 启用持久化日志环
+bool Logger::enableJournal(const QString& journalFilePath, qint64 capacity)
+{
+    QMutexLocker journalLocker(&d->journalMutex);
+    // 先停用并释放旧的日志环，新日志环可能使用同一个文件
+    if (!d->retireJournal()) {
+        return false;
+    }
+    Journal* journal = new Journal;
+    if (!journal->open(journalFilePath, capacity)) {
+        delete journal;
+        return false;
+    }
+    // 持有 drainMutex 时写入线程不在提交序号
+    QMutexLocker locker(&d->drainMutex);
+    journal->setCommittedSequence(d->committedSequence.load(std::memory_order_relaxed));
+    d->journal.store(journal, std::memory_order_release);
+    return true;
+}
+
+// 停用持久化日志环
+void Logger::disableJournal()
+{
+    QMutexLocker locker(&d->journalMutex);
+    d->retireJournal();
+}
+
+// 设置写入线程的调度设置，由写入线程在下一次循环时应用
+void Logger::setWriterThreadOptions(const WriterThreadOptions& options)
+{
+    {
+        QMutexLocker locker(&d->writerOptionsMutex);
+        d->writerOptions = options;
+        d->writerOptionsVersion.fetch_add(1, std::memory_order_release);
+    }
+    d->wakeWriter();
+}
+
+// 获取写入线程的调度设置
+WriterThreadOptions Logger::writerThreadOptions() const
+{
+    QMutexLocker locker(&d->writerOptionsMutex);
+    return d->writerOptions;
+}
+
+// 在调用线程上写出所有待处理的日志
+int Logger::processPendingMessages()
+{
+    return d->drainOnCallerThread();
+}
+
 // -- Logger 补充实现 --
-// 刷新日志：等待消息队列中的所有消息被处理
-void Logger::flush()
+// 刷新日志：等待调用前入队的所有记录写入并同步到所有目的地
+bool Logger::flush(int timeoutMs)
+{
+    return d->flush(timeoutMs);
+}
+
+// 发出刷新请求，不等待完成
+QFuture<bool> Logger::flushAsync()
 {
-    // 锁定互斥锁以检查队列状态
-    QMutexLocker locker(&d->queueMutex);
-    // 循环直到消息队列为空
-    while (!d->messageQueue.isEmpty()) {
-        // 暂时解锁，让日志写入线程有机会处理消息
-        locker.unlock();
-        // 睡眠 50 毫秒
-        QThread::msleep(50);
-        // 重新锁定
-        locker.relock();
+    return d->requestFlush()->future.future();
+}
+
+// 获取已写入并同步到所有目的地的最大序号
+quint64 Logger::committedSequence() const
+{
+    return d->committedSequence.load(std::memory_order_acquire);
+}
+
+// 设置当前线程在日志中的名称
+void Logger::setThreadName(const QString& name)
+{
+    if (!t_threadIdentityReleased) {
+        t_threadIdentity.name = name;
     }
 }
 
+// Logger::Helper 的构造函数：优先使用当前线程的格式化缓冲区
+Logger::Helper::Helper(Level logLevel, const LogSite* logSite) :
+    level(logLevel),
+    site(logSite),
+    timestamp(Clock::now()),
+    raw(false),
+    deferred(false),
+    structured(false),
+    ownsBuffer(false),
+    buffer(nullptr),
+    qtDebug(nullptr)
+{
+    if (!t_formatBufferReleased && !t_formatBuffer.buffer.inUse) {
+        buffer = &t_formatBuffer.buffer;
+    } else {
+        // 在格式化过程中又写了一条日志（嵌套），或线程正在退出：使用临时缓冲区
+        buffer = new FormatBuffer;
+        ownsBuffer = true;
+    }
+    buffer->inUse = true;
+    // 清除上一条日志留下的 nospace/noquote 等格式状态
+    buffer->debug.resetFormat();
+    qtDebug = &buffer->debug;
+}
+
+// 获取延迟格式化流
+DeferredStream& Logger::Helper::deferredStream()
+{
+    deferred = true;
+    buffer->deferred.begin(raw);
+    return buffer->deferred;
+}
+
+// 获取原始模式的延迟格式化流
+DeferredStream& Logger::Helper::rawDeferredStream()
+{
+    raw = true;
+    return deferredStream();
+}
+
+// 切换到结构化模式
+StructuredStream& Logger::Helper::structuredStream()
+{
+    structured = true;
+    return buffer->structured;
+}
+
+// 获取格式化输出器：格式化日志的文本完全由格式字符串决定，按原始模式处理
+FormatWriter Logger::Helper::formatWriter()
+{
+    raw = true;
+    return FormatWriter(&buffer->text, &buffer->debug);
+}
+
 // Logger::Helper 的析构函数
 Logger::Helper::~Helper()
 {
     try {
-        QString finalMessage;
-        // 静态数组，用于将日志级别转换为字符串
-        static const char* const level_string[] = {
-            "TRACE", "DEBUG", "INFO", "WARNING", "ERROR", "FATAL", "OFF"
-        };
-
-        // 获取并处理日志消息
-        finalMessage += buffer.trimmed();
+        // 每条日志只在这里创建一次记录，之后由队列和所有目的地共享
+        LogMetadata metadata;
+        metadata.site = site;
+        metadata.timestamp = timestamp;
+        captureThreadIdentity(metadata);
+        LogMessage message;
+        if (structured) {
+            // 结构化日志：只拷贝消息和字段的记录，由写入线程还原
+            message.record = LoggerImpl::createStructuredRecord(
+                level, metadata, buffer->arguments.constData(), buffer->arguments.size());
+        } else if (deferred) {
+            // 延迟格式化：只拷贝参数记录，文本由写入线程生成
+            message.record = LoggerImpl::createDeferredRecord(
+                level, metadata, buffer->arguments.constData(), buffer->arguments.size());
+        } else {
+            // 直接在缓冲区上计算去除首尾空白后的范围，代替 trimmed() 产生的拷贝
+            const QString& text = buffer->text;
+            int begin = 0;
+            int end = text.size();
+            if (!raw) {
+                while (begin < end && text.at(begin).isSpace()) {
+                    ++begin;
+                }
+                while (end > begin && text.at(end - 1).isSpace()) {
+                    --end;
+                }
+            }
+            message.record = LoggerImpl::createRecord(level, metadata, text.constData() + begin, end - begin);
+        }
 
-        // 锁定互斥锁，将消息添加到队列
-        QMutexLocker locker(&Logger::instance().d->queueMutex);
-        Logger::instance().d->messageQueue.enqueue({ finalMessage, level });
-        // 唤醒日志写入线程，通知其有新消息需要处理
-        Logger::instance().d->queueWaitCondition.wakeOne();
+        ActiveCall call;
+        if (!call.entered) {
+            // 单例已经开始关闭，不再创建新的单例，日志计入保留下来的单例的丢弃数
+            message.record.clear();
+            s_instance.load(std::memory_order_acquire)->d->droppedMessages[level].fetch_add(
+                1, std::memory_order_relaxed);
+        } else {
+            // 将消息放入无锁队列，必要时唤醒日志写入线程
+            LoggerImpl* impl = Logger::instance().d;
+            impl->enqueue(std::move(message));
+            // 达到同步级别的日志在返回前等待此前入队的日志连同它一起写入并同步所有目的地，
+            // 紧随其后的 abort() 不会使它丢失；更低的级别保持完全异步
+            if (static_cast<int>(level) >= impl->synchronousLevel.load(std::memory_order_relaxed)) {
+                impl->flush(impl->synchronousTimeout.load(std::memory_order_relaxed));
+            }
+        }
 
     } catch(std::exception&) {
         // 捕获异常，如果析构函数中发生异常，则断言失败
         Q_ASSERT(!"exception in logger helper destructor");
     }
+
+    // 归还缓冲区：保留常规大小的容量供下一条日志复用
+    if (buffer->text.capacity() > FormatBufferRetainedCapacity) {
+        buffer->text.clear();
+    } else {
+        buffer->text.resize(0);
+    }
+    if (buffer->arguments.capacity() > FormatBufferRetainedCapacity) {
+        buffer->arguments.clear();
+        buffer->arguments.reserve(ArgumentsInitialCapacity);
+    } else {
+        buffer->arguments.resize(0);
+    }
+    buffer->inUse = false;
+    if (ownsBuffer) {
+        delete buffer;
+    }
 }
 
 } // end namespace
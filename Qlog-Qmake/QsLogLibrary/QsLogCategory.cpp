@@ -0,0 +1,181 @@
+﻿#include "QsLogCategory.h"
+#include <QByteArray>
+#include <QDebug>
+#include <QMutex>
+#include <QStringList>
+#include <QVector>
+#include <cstring>
+
+namespace QsLogging
+{
+
+namespace
+{
+
+// 表示跟随全局级别
+static const int InheritLevel = -1;
+
+// 一条类别规则
+struct CategoryRule
+{
+    QByteArray pattern; // 类别名或通配模式（UTF-8）
+    int level;          // 规则指定的级别，InheritLevel 表示跟随全局级别
+};
+
+// 判断类别名是否匹配规则中的模式
+bool matchesPattern(const QByteArray& pattern, const char* name)
+{
+    if (pattern == "*") {
+        return true;
+    }
+    if (pattern.endsWith(".*")) {
+        // "net.*" 匹配 "net" 以及 "net.http"、"net.http.client" 等子类别
+        const int prefixLength = pattern.size() - 2;
+        return std::strncmp(name, pattern.constData(), prefixLength) == 0
+               && (name[prefixLength] == '\0' || name[prefixLength] == '.');
+    }
+    return pattern == name;
+}
+
+// 解析级别名称，无法识别时返回 false
+bool parseLevel(const QString& text, int* level)
+{
+    const QString name = text.trimmed().toLower();
+    if (name == "trace") {
+        *level = TraceLevel;
+    } else if (name == "debug") {
+        *level = DebugLevel;
+    } else if (name == "info") {
+        *level = InfoLevel;
+    } else if (name == "warn" || name == "warning") {
+        *level = WarnLevel;
+    } else if (name == "error") {
+        *level = ErrorLevel;
+    } else if (name == "fatal") {
+        *level = FatalLevel;
+    } else if (name == "off") {
+        *level = OffLevel;
+    } else if (name == "default") {
+        *level = InheritLevel;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // end anonymous namespace
+
+// 类别注册表数据。有意不释放：静态类别可能在注册表之后析构
+struct CategoryRegistryData
+{
+    CategoryRegistryData() : defaultLevel(InfoLevel) {}
+
+    QMutex mutex;
+    QVector<Category*> categories;
+    QVector<CategoryRule> rules;
+    int defaultLevel; // 与 Logger 的全局级别保持一致
+
+    // 根据规则计算类别的级别，调用方需持有 mutex
+    void apply(Category* category) const
+    {
+        int level = InheritLevel;
+        for (const CategoryRule& rule : rules) {
+            if (matchesPattern(rule.pattern, category->m_name)) {
+                level = rule.level;
+            }
+        }
+        category->m_threshold.store(level == InheritLevel ? defaultLevel : level,
+                                    std::memory_order_relaxed);
+    }
+
+    void applyAll() const
+    {
+        for (Category* category : categories) {
+            apply(category);
+        }
+    }
+};
+
+static CategoryRegistryData& categoryRegistry()
+{
+    static CategoryRegistryData* data = new CategoryRegistryData;
+    return *data;
+}
+
+Category::Category(const char* name) :
+    m_name(name),
+    m_threshold(InfoLevel)
+{
+    CategoryRegistryData& registry = categoryRegistry();
+    QMutexLocker locker(&registry.mutex);
+    registry.categories.append(this);
+    registry.apply(this);
+}
+
+Category::~Category()
+{
+    CategoryRegistryData& registry = categoryRegistry();
+    QMutexLocker locker(&registry.mutex);
+    registry.categories.removeOne(this);
+}
+
+Level Category::level() const
+{
+    return static_cast<Level>(m_threshold.load(std::memory_order_relaxed));
+}
+
+void Category::setRules(const QString& rules)
+{
+    QVector<CategoryRule> parsed;
+    QString normalized = rules;
+    normalized.replace(',', ';').replace('\n', ';');
+    const QStringList entries = normalized.split(';');
+    for (const QString& entry : entries) {
+        if (entry.trimmed().isEmpty()) {
+            continue;
+        }
+        const int separator = entry.indexOf('=');
+        CategoryRule rule;
+        if (separator <= 0 || !parseLevel(entry.mid(separator + 1), &rule.level)) {
+            qWarning() << "QsLog: Ignoring invalid category rule:" << entry;
+            continue;
+        }
+        rule.pattern = entry.left(separator).trimmed().toUtf8();
+        parsed.append(rule);
+    }
+
+    CategoryRegistryData& registry = categoryRegistry();
+    QMutexLocker locker(&registry.mutex);
+    registry.rules = parsed;
+    registry.applyAll();
+}
+
+void Category::setLevel(const QString& pattern, Level level)
+{
+    CategoryRule rule;
+    rule.pattern = pattern.trimmed().toUtf8();
+    rule.level = level;
+
+    CategoryRegistryData& registry = categoryRegistry();
+    QMutexLocker locker(&registry.mutex);
+    registry.rules.append(rule);
+    registry.applyAll();
+}
+
+void Category::resetRules()
+{
+    CategoryRegistryData& registry = categoryRegistry();
+    QMutexLocker locker(&registry.mutex);
+    registry.rules.clear();
+    registry.applyAll();
+}
+
+void Category::setDefaultLevel(Level level)
+{
+    CategoryRegistryData& registry = categoryRegistry();
+    QMutexLocker locker(&registry.mutex);
+    registry.defaultLevel = level;
+    registry.applyAll();
+}
+
+} // end namespace
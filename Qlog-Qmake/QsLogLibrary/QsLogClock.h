@@ -0,0 +1,31 @@
+﻿#ifndef QSLOGCLOCK_H
+#define QSLOGCLOCK_H
+
+#include "QsLogDest.h"
+#include <QDateTime>
+#include <QtGlobal>
+#include <chrono>
+
+namespace QsLogging
+{
+
+// 日志时间戳使用的时钟。调用点只读取单调时钟的纳秒值，开销远低于 QDateTime::currentDateTime()；
+// 进程内首次换算时记录一次单调时钟与系统时间的对应关系，之后按该锚点换算为墙上时间。
+class QSLOG_SHARED_OBJECT Clock
+{
+public:
+    // 单调时钟的当前读数（纳秒）
+    static qint64 now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    // 将单调时钟读数换算为自 1970-01-01 UTC 起的纳秒数
+    static qint64 toEpochNanoseconds(qint64 timestamp);
+    // 将单调时钟读数换算为本地时间
+    static QDateTime toDateTime(qint64 timestamp);
+};
+
+} // end namespace QsLogging
+
+#endif // QSLOGCLOCK_H
@@ -0,0 +1,296 @@
+﻿#include "QsLogDestAsync.h"
+#include "QsLogClock.h"
+#include "QsLogCrash.h"
+#include "QsLogRecord.h"
+#include "QsLogRingBuffer.h"
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+
+namespace QsLogging
+{
+
+// 工作线程每次最多交给被包装目标的记录数
+static const int MaxAsyncBatch = 1024;
+
+// 异步目标的队列与工作线程
+class AsyncDestinationImpl : public QThread
+{
+public:
+    AsyncDestinationImpl(const DestinationPtr& destination, int queueCapacity, bool blockWhenFull);
+    ~AsyncDestinationImpl();
+
+    void run() override;
+    // 把一条记录放入队列，返回是否成功；只由日志写入线程调用
+    bool push(const LogRecordPtr& record);
+    // 有记录入队后，在工作线程空闲等待时唤醒它
+    void signalWorker();
+    // 唤醒空闲等待的工作线程
+    void wakeWorker();
+    // 崩溃转储来源：写出尚未交给被包装目标的记录，context 为 AsyncDestinationImpl
+    static void dumpQueuedRecords(CrashDumpWriter& writer, void* context);
+
+    DestinationPtr destination;          // 被包装的目标
+    SpscRingBuffer<LogRecordPtr> queue;  // 日志写入线程 -> 工作线程，空指针表示同步请求
+    LogRecordList batch;                 // 工作线程已取出、尚未写完的记录
+    const bool blockWhenFull;            // 队列已满时是否阻塞等待
+    QMutex mutex;                        // 用于工作线程空闲等待与同步请求的完成通知
+    QWaitCondition condition;
+    QWaitCondition syncCondition;        // 同步请求完成时通知
+    QWaitCondition idleCondition;        // 有 waitForIdle() 在等待时，每写完一批通知一次
+    std::atomic_int idleWaiters;         // 正在 waitForIdle() 中等待的线程数
+    std::atomic_bool workerWaiting;      // 工作线程是否正在等待新记录
+    std::atomic_bool stopSignal;         // 写完剩余记录后退出
+    std::atomic<quint64> enqueued;       // 已入队的记录数
+    std::atomic<quint64> written;        // 已写完的记录数
+    std::atomic<quint64> dropped;        // 因队列已满丢弃的记录数
+    std::atomic<qint64> lastLag;         // 最近一批的最大延迟
+    std::atomic<qint64> maxLag;          // 最大延迟
+    quint64 syncRequested;               // 已发出的同步请求数，只由日志写入线程访问
+    quint64 syncCompleted;               // 已完成的同步请求数，由 mutex 保护
+    bool syncResult;                     // 最近一次同步的结果，由 mutex 保护
+};
+
+AsyncDestinationImpl::AsyncDestinationImpl(const DestinationPtr& destination_, int queueCapacity,
+                                           bool blockWhenFull_) :
+    destination(destination_),
+    queue(static_cast<size_t>(qMax(queueCapacity, 2))),
+    blockWhenFull(blockWhenFull_),
+    idleWaiters(0),
+    workerWaiting(false),
+    stopSignal(false),
+    enqueued(0),
+    written(0),
+    dropped(0),
+    lastLag(0),
+    maxLag(0),
+    syncRequested(0),
+    syncCompleted(0),
+    syncResult(true)
+{
+    setObjectName(QString("QsLog async destination"));
+    CrashHandler::addSource(&AsyncDestinationImpl::dumpQueuedRecords, this);
+}
+
+AsyncDestinationImpl::~AsyncDestinationImpl()
+{
+    CrashHandler::removeSource(&AsyncDestinationImpl::dumpQueuedRecords, this);
+}
+
+void AsyncDestinationImpl::run()
+{
+    batch.reserve(MaxAsyncBatch);
+    LogRecordPtr record;
+    for (;;) {
+        bool syncPending = false;
+        while (batch.size() < MaxAsyncBatch && queue.tryPop(record)) {
+            if (!record) {
+                // 同步请求：先写完请求之前入队的记录再同步
+                syncPending = true;
+                break;
+            }
+            batch.append(record);
+            record.clear();
+        }
+        if (!batch.isEmpty()) {
+            if (destination->isValid()) {
+                destination->writeBatch(batch);
+            }
+            const qint64 now = Clock::now();
+            qint64 lag = 0;
+            for (const LogRecordPtr& entry : batch) {
+                lag = qMax(lag, now - entry->timestamp());
+            }
+            lastLag.store(lag, std::memory_order_relaxed);
+            if (lag > maxLag.load(std::memory_order_relaxed)) {
+                maxLag.store(lag, std::memory_order_relaxed);
+            }
+            written.fetch_add(batch.size(), std::memory_order_release);
+            batch.clear();
+            // 更新写完计数与读取等待数之间需要全屏障，与 waitForIdle() 的检查顺序相对应
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (idleWaiters.load(std::memory_order_relaxed) > 0) {
+                QMutexLocker locker(&mutex);
+                idleCondition.wakeAll();
+            }
+        }
+        if (syncPending) {
+            const bool synced = destination->isValid() && destination->sync();
+            QMutexLocker locker(&mutex);
+            syncResult = synced;
+            ++syncCompleted;
+            syncCondition.wakeAll();
+            continue;
+        }
+        if (!queue.isEmpty()) {
+            continue;
+        }
+        // 先读取停止信号再确认队列为空，保证退出前写完所有已入队的记录
+        if (stopSignal.load(std::memory_order_acquire) && queue.isEmpty()) {
+            break;
+        }
+        QMutexLocker locker(&mutex);
+        workerWaiting.store(true, std::memory_order_relaxed);
+        // 设置等待标志后再次检查，避免与入队操作交错而漏掉唤醒
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (queue.isEmpty() && !stopSignal.load(std::memory_order_relaxed)) {
+            condition.wait(&mutex);
+        }
+        workerWaiting.store(false, std::memory_order_relaxed);
+    }
+}
+
+bool AsyncDestinationImpl::push(const LogRecordPtr& record)
+{
+    LogRecordPtr entry(record);
+    while (!queue.tryPush(std::move(entry))) {
+        if (!blockWhenFull) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        wakeWorker();
+        QThread::yieldCurrentThread();
+    }
+    enqueued.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void AsyncDestinationImpl::signalWorker()
+{
+    // 入队与读取等待标志之间需要全屏障，与工作线程的检查顺序相对应
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (workerWaiting.load(std::memory_order_relaxed)
+        && workerWaiting.exchange(false, std::memory_order_relaxed)) {
+        wakeWorker();
+    }
+}
+
+void AsyncDestinationImpl::wakeWorker()
+{
+    // 工作线程在持有 mutex 时检查队列并进入等待，加锁后唤醒不会错过
+    QMutexLocker locker(&mutex);
+    condition.wakeOne();
+}
+
+void AsyncDestinationImpl::dumpQueuedRecords(CrashDumpWriter& writer, void* context)
+{
+    // 运行在崩溃处理函数中，只读取工作线程的批次和队列；空指针是同步请求的标记
+    const AsyncDestinationImpl* impl = static_cast<const AsyncDestinationImpl*>(context);
+    for (const LogRecordPtr& record : impl->batch) {
+        writer.write(*record);
+    }
+    impl->queue.peek([&writer](const LogRecordPtr& record) {
+        if (record) {
+            writer.write(*record);
+        }
+    });
+}
+
+// -- AsyncDestination 实现 --
+AsyncDestination::AsyncDestination(const DestinationPtr& destination, int queueCapacity, bool blockWhenFull) :
+    d(new AsyncDestinationImpl(destination, queueCapacity, blockWhenFull))
+{
+    Q_ASSERT(destination.data());
+    d->start();
+}
+
+AsyncDestination::~AsyncDestination()
+{
+    d->stopSignal.store(true, std::memory_order_release);
+    d->wakeWorker();
+    d->wait();
+    delete d;
+}
+
+void AsyncDestination::write(const QString& message, Level level)
+{
+    LogMetadata metadata;
+    metadata.timestamp = Clock::now();
+    writeBatch(LogRecordList() << LogRecordPtr(new LogRecord(level, metadata, message)));
+}
+
+void AsyncDestination::writeRecord(const LogRecord& record)
+{
+    writeBatch(LogRecordList() << LogRecordPtr(new LogRecord(record)));
+}
+
+void AsyncDestination::writeBatch(const LogRecordList& records)
+{
+    for (const LogRecordPtr& record : records) {
+        d->push(record);
+    }
+    d->signalWorker();
+}
+
+bool AsyncDestination::isValid()
+{
+    return d->destination->isValid();
+}
+
+bool AsyncDestination::sync()
+{
+    // 同步请求不受 blockWhenFull 影响，队列已满时一直等待空间
+    while (!d->queue.tryPush(LogRecordPtr())) {
+        d->wakeWorker();
+        QThread::yieldCurrentThread();
+    }
+    const quint64 ticket = ++d->syncRequested;
+    d->signalWorker();
+    QMutexLocker locker(&d->mutex);
+    while (d->syncCompleted < ticket) {
+        d->syncCondition.wait(&d->mutex);
+    }
+    return d->syncResult;
+}
+
+bool AsyncDestination::waitForIdle(int timeoutMs)
+{
+    // 等待前记下目标：等待期间新入队的记录不计入
+    const quint64 target = d->enqueued.load(std::memory_order_relaxed);
+    if (d->written.load(std::memory_order_acquire) >= target) {
+        return true;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    QMutexLocker locker(&d->mutex);
+    d->idleWaiters.fetch_add(1, std::memory_order_relaxed);
+    // 登记等待后再检查写完计数，工作线程写完一批后在持有 mutex 时通知，不会错过
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool idle = true;
+    while (d->written.load(std::memory_order_acquire) < target) {
+        if (timeoutMs < 0) {
+            d->idleCondition.wait(&d->mutex);
+            continue;
+        }
+        const qint64 remaining = timeoutMs - timer.elapsed();
+        if (remaining <= 0 || (!d->idleCondition.wait(&d->mutex, static_cast<unsigned long>(remaining))
+                               && d->written.load(std::memory_order_acquire) < target)) {
+            idle = false;
+            break;
+        }
+    }
+    d->idleWaiters.fetch_sub(1, std::memory_order_relaxed);
+    return idle;
+}
+
+AsyncDestinationStatistics AsyncDestination::statistics() const
+{
+    AsyncDestinationStatistics result;
+    result.written = d->written.load(std::memory_order_acquire);
+    const quint64 enqueued = d->enqueued.load(std::memory_order_relaxed);
+    result.queued = enqueued > result.written ? enqueued - result.written : 0;
+    result.dropped = d->dropped.load(std::memory_order_relaxed);
+    result.lastLagNanoseconds = d->lastLag.load(std::memory_order_relaxed);
+    result.maxLagNanoseconds = d->maxLag.load(std::memory_order_relaxed);
+    return result;
+}
+
+void AsyncDestination::resetStatistics()
+{
+    d->dropped.store(0, std::memory_order_relaxed);
+    d->maxLag.store(0, std::memory_order_relaxed);
+}
+
+} // end namespace QsLogging
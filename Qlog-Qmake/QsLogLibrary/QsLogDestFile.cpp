@@ -1,4 +1,6 @@
 ﻿#include "QsLogDestFile.h"
+#include "QsLogClock.h"
+#include "QsLogSite.h"
 #include <QDateTime>
 #include <QDebug>
 #include <QSqlError>
@@ -48,8 +50,13 @@ void DatabaseDestination::initDatabase(const QString& dbFilePath)
     QString createTableSql = "CREATE TABLE IF NOT EXISTS log_entries ("
                              "id INTEGER PRIMARY KEY AUTOINCREMENT, "
                              "timestamp TEXT NOT NULL, "
+                             "timestamp_ns INTEGER, "
                              "level INTEGER NOT NULL, "
-                             "message TEXT NOT NULL"
+                             "message TEXT NOT NULL, "
+                             "site_id INTEGER REFERENCES log_sites(id), "
+                             "thread_id INTEGER, "
+                             "thread_name TEXT, "
+                             "sequence INTEGER"
                              ");";
 
     if (!createTableQuery.exec(createTableSql)) {
@@ -59,33 +66,267 @@ void DatabaseDestination::initDatabase(const QString& dbFilePath)
         return;
     }
 
+    // 调用点表：每个调用点只保存一次，日志记录通过 site_id 引用，
+    // 与 log_entries 关联即可还原每条日志的文件、行号和函数
+    QString createSitesSql = "CREATE TABLE IF NOT EXISTS log_sites ("
+                             "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                             "file TEXT NOT NULL, "
+                             "line INTEGER NOT NULL, "
+                             "function TEXT NOT NULL, "
+                             "level INTEGER NOT NULL, "
+                             "format TEXT, "
+                             "category TEXT, "
+                             "UNIQUE (file, line, function, level)"
+                             ");";
+
+    // 结构化字段表：每个字段一行，值保留原始类型，可按字段名建立索引后直接查询
+    QString createFieldsSql = "CREATE TABLE IF NOT EXISTS log_fields ("
+                              "entry_id INTEGER NOT NULL REFERENCES log_entries(id), "
+                              "key TEXT NOT NULL, "
+                              "value"
+                              ");";
+
+    if (!createTableQuery.exec(createSitesSql)
+        || !createTableQuery.exec(createFieldsSql)
+        || !createTableQuery.exec("CREATE INDEX IF NOT EXISTS log_fields_key ON log_fields (key, value)")
+        || !ensureColumn("log_entries", "site_id", "INTEGER REFERENCES log_sites(id)")
+        || !ensureColumn("log_sites", "category", "TEXT")
+        || !ensureColumn("log_entries", "timestamp_ns", "INTEGER")
+        || !ensureColumn("log_entries", "thread_id", "INTEGER")
+        || !ensureColumn("log_entries", "thread_name", "TEXT")
+        || !ensureColumn("log_entries", "sequence", "INTEGER")
+        // 导入恢复的记录时按序号与时间戳查找已有记录
+        || !createTableQuery.exec("CREATE INDEX IF NOT EXISTS log_entries_sequence ON log_entries (sequence, timestamp_ns)")) {
+        qWarning() << "QsLog: Failed to create log_sites/log_fields tables:" << createTableQuery.lastError().text();
+        m_db.close();
+        m_isDbValid = false;
+        return;
+    }
+
     // 预处理插入查询，以提高性能
     m_query = QSqlQuery(m_db);
-    m_query.prepare("INSERT INTO log_entries (timestamp, level, message) VALUES (:timestamp, :level, :message)");
+    m_query.prepare("INSERT INTO log_entries (timestamp, timestamp_ns, level, message, site_id, thread_id, thread_name, "
+                    "sequence) VALUES (:timestamp, :timestamp_ns, :level, :message, :site_id, :thread_id, :thread_name, "
+                    ":sequence)");
+    m_siteInsertQuery = QSqlQuery(m_db);
+    m_siteInsertQuery.prepare("INSERT OR IGNORE INTO log_sites (file, line, function, level, format, category) "
+                              "VALUES (:file, :line, :function, :level, :format, :category)");
+    m_fieldInsertQuery = QSqlQuery(m_db);
+    m_fieldInsertQuery.prepare("INSERT INTO log_fields (entry_id, key, value) VALUES (:entry_id, :key, :value)");
+    m_siteSelectQuery = QSqlQuery(m_db);
+    m_siteSelectQuery.prepare("SELECT id FROM log_sites "
+                              "WHERE file = :file AND line = :line AND function = :function AND level = :level");
+    m_entrySelectQuery = QSqlQuery(m_db);
+    m_entrySelectQuery.prepare("SELECT 1 FROM log_entries WHERE sequence = :sequence AND timestamp_ns = :timestamp_ns");
 
     m_isDbValid = true;
 }
 
+// 为旧版本数据库中的表补充缺少的列
+bool DatabaseDestination::ensureColumn(const QString& table, const QString& column, const QString& definition)
+{
+    QSqlQuery query(m_db);
+    if (!query.exec(QString("PRAGMA table_info(\"%1\")").arg(table))) {
+        return false;
+    }
+    while (query.next()) {
+        if (query.value("name").toString() == column) {
+            return true;
+        }
+    }
+    return query.exec(QString("ALTER TABLE \"%1\" ADD COLUMN %2 %3").arg(table, column, definition));
+}
+
+// 获取调用点在 log_sites 表中的行号
+qint64 DatabaseDestination::siteRow(const LogSite* site)
+{
+    const auto cached = m_siteRows.constFind(site->id);
+    if (cached != m_siteRows.constEnd()) {
+        return cached.value();
+    }
+
+    const qint64 row = siteRow(QString::fromUtf8(site->file), site->line, QString::fromUtf8(site->function), site->level,
+                               site->format ? QVariant(QString::fromUtf8(site->format)) : QVariant(QVariant::String),
+                               site->category ? QVariant(QString::fromUtf8(site->category))
+                                              : QVariant(QVariant::String));
+    if (row >= 0) {
+        m_siteRows.insert(site->id, row);
+    }
+    return row;
+}
+
+// 按调用点的文本信息获取行号
+qint64 DatabaseDestination::siteRow(const QString& file, int line, const QString& function, Level level,
+                                    const QVariant& format, const QVariant& category)
+{
+    m_siteInsertQuery.bindValue(":file", file);
+    m_siteInsertQuery.bindValue(":line", line);
+    m_siteInsertQuery.bindValue(":function", function);
+    m_siteInsertQuery.bindValue(":level", levelToInt(level));
+    m_siteInsertQuery.bindValue(":format", format);
+    m_siteInsertQuery.bindValue(":category", category);
+    if (!m_siteInsertQuery.exec()) {
+        qWarning() << "QsLog: Failed to insert log site:" << m_siteInsertQuery.lastError().text();
+        return -1;
+    }
+
+    // 同一调用点可能已由之前的进程登记过，统一按唯一键查询行号
+    m_siteSelectQuery.bindValue(":file", file);
+    m_siteSelectQuery.bindValue(":line", line);
+    m_siteSelectQuery.bindValue(":function", function);
+    m_siteSelectQuery.bindValue(":level", levelToInt(level));
+    if (!m_siteSelectQuery.exec() || !m_siteSelectQuery.next()) {
+        qWarning() << "QsLog: Failed to query log site:" << m_siteSelectQuery.lastError().text();
+        return -1;
+    }
+    const qint64 row = m_siteSelectQuery.value(0).toLongLong();
+    m_siteSelectQuery.finish();
+    return row;
+}
+
 // 写入日志到数据库
 void DatabaseDestination::write(const QString& message, Level level)
 {
     if (!m_isDbValid) {
         return;
     }
+    // 没有调用点信息时以写入时间为准，线程信息留空
+    LogMetadata metadata;
+    metadata.timestamp = Clock::now();
+    writeEntry(message, level, -1, metadata, LogFields());
+}
+
+// 写入日志记录，消息中不再重复保存文件和行号
+void DatabaseDestination::writeRecord(const LogRecord& record)
+{
+    if (!m_isDbValid) {
+        return;
+    }
+    writeEntry(record.message(), record.level(), record.site() ? siteRow(record.site()) : -1,
+               record.metadata(), record.fields());
+}
+
+// 写入一批日志记录：整批只提交一次事务
+void DatabaseDestination::writeBatch(const LogRecordList& records)
+{
+    if (!m_isDbValid || records.isEmpty()) {
+        return;
+    }
+    // 先在事务之外解析调用点的行号，新调用点的登记不会随批次一起回滚
+    QVector<qint64> siteRows;
+    siteRows.reserve(records.size());
+    for (const LogRecordPtr& record : records) {
+        siteRows.append(record->site() ? siteRow(record->site()) : -1);
+    }
 
-    // 使用事务以提高写入性能
     m_db.transaction();
+    for (int i = 0; i < records.size(); ++i) {
+        const LogRecord& record = *records.at(i);
+        if (!insertEntry(record.message(), record.level(), siteRows.at(i), record.metadata(), record.fields())) {
+            // 撤销整批后逐条重写，只丢失出错的那一条
+            m_db.rollback();
+            for (int j = 0; j < records.size(); ++j) {
+                const LogRecord& retry = *records.at(j);
+                writeEntry(retry.message(), retry.level(), siteRows.at(j), retry.metadata(), retry.fields());
+            }
+            return;
+        }
+    }
+    m_db.commit();
+}
 
-    m_query.bindValue(":timestamp", QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz"));
+// 在单独的事务中写入一条日志记录
+void DatabaseDestination::writeEntry(const QString& message, Level level, qint64 siteRow, const LogMetadata& metadata,
+                                     const LogFields& fields)
+{
+    m_db.transaction();
+    if (insertEntry(message, level, siteRow, metadata, fields)) {
+        m_db.commit();
+    } else {
+        m_db.rollback();
+    }
+}
+
+// 在当前事务中插入一条日志记录
+bool DatabaseDestination::insertEntry(const QString& message, Level level, qint64 siteRow, const LogMetadata& metadata,
+                                      const LogFields& fields)
+{
+    // timestamp 列保留原有的可读格式，timestamp_ns 保存纳秒精度的 UTC 时间，用于精确排序
+    m_query.bindValue(":timestamp", Clock::toDateTime(metadata.timestamp).toString("yyyy-MM-dd hh:mm:ss.zzz"));
+    m_query.bindValue(":timestamp_ns", Clock::toEpochNanoseconds(metadata.timestamp));
     m_query.bindValue(":level", levelToInt(level));
     m_query.bindValue(":message", message);
+    m_query.bindValue(":site_id", siteRow >= 0 ? QVariant(siteRow) : QVariant(QVariant::LongLong));
+    m_query.bindValue(":thread_id", metadata.threadId ? QVariant(metadata.threadId) : QVariant(QVariant::ULongLong));
+    m_query.bindValue(":thread_name", metadata.threadName.isEmpty() ? QVariant(QVariant::String)
+                                                                    : QVariant(metadata.threadName));
+    m_query.bindValue(":sequence", metadata.sequence ? QVariant(metadata.sequence) : QVariant(QVariant::ULongLong));
 
     if (!m_query.exec()) {
         qWarning() << "QsLog: Failed to insert log entry:" << m_query.lastError().text();
-        m_db.rollback();
-    } else {
-        m_db.commit();
+        return false;
+    }
+
+    // 结构化字段与日志记录在同一事务中写入
+    if (!fields.isEmpty()) {
+        const QVariant entryId = m_query.lastInsertId();
+        for (const LogField& field : fields) {
+            m_fieldInsertQuery.bindValue(":entry_id", entryId);
+            m_fieldInsertQuery.bindValue(":key", field.key);
+            m_fieldInsertQuery.bindValue(":value", field.value);
+            if (!m_fieldInsertQuery.exec()) {
+                qWarning() << "QsLog: Failed to insert log field:" << m_fieldInsertQuery.lastError().text();
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 导入其他进程留下的记录
+int DatabaseDestination::importRecords(const QVector<RecoveredRecord>& records)
+{
+    if (!m_isDbValid) {
+        return -1;
+    }
+    // 恢复的时间已是纪元纳秒，换算为本进程的单调时钟读数后沿用 insertEntry()
+    const qint64 epochOffset = Clock::toEpochNanoseconds(0);
+    int imported = 0;
+    m_db.transaction();
+    for (const RecoveredRecord& entry : records) {
+        // 崩溃前可能已经写入数据库的记录（例如目的地正在提交的批次）不重复导入
+        if (entry.sequence != 0) {
+            m_entrySelectQuery.bindValue(":sequence", entry.sequence);
+            m_entrySelectQuery.bindValue(":timestamp_ns", entry.epochNanoseconds);
+            if (!m_entrySelectQuery.exec()) {
+                qWarning() << "QsLog: Failed to query log entry:" << m_entrySelectQuery.lastError().text();
+                m_db.rollback();
+                return -1;
+            }
+            const bool exists = m_entrySelectQuery.next();
+            m_entrySelectQuery.finish();
+            if (exists) {
+                continue;
+            }
+        }
+        const qint64 site = entry.file.isEmpty()
+            ? -1
+            : siteRow(entry.file, entry.line, entry.function, entry.level,
+                      entry.format.isEmpty() ? QVariant(QVariant::String) : QVariant(entry.format),
+                      entry.category.isEmpty() ? QVariant(QVariant::String) : QVariant(entry.category));
+        LogMetadata metadata;
+        metadata.timestamp = entry.epochNanoseconds - epochOffset;
+        metadata.threadId = entry.threadId;
+        metadata.threadName = entry.threadName;
+        metadata.sequence = entry.sequence;
+        if (!insertEntry(entry.message, entry.level, site, metadata, entry.fields)) {
+            m_db.rollback();
+            return -1;
+        }
+        ++imported;
     }
+    m_db.commit();
+    return imported;
 }
 
 // 检查数据库连接是否有效
@@ -94,4 +335,10 @@ bool DatabaseDestination::isValid()
     return m_isDbValid;
 }
 
+// 记录在写入时已经提交
+bool DatabaseDestination::sync()
+{
+    return m_isDbValid;
+}
+
 } // end namespace
@@ -0,0 +1,21 @@
+﻿#ifndef QSLOGFIELD_H
+#define QSLOGFIELD_H
+
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+namespace QsLogging
+{
+
+// 结构化日志中的一个字段，由写入线程从记录中还原，值保留原始类型
+struct LogField
+{
+    QString key;
+    QVariant value;
+};
+typedef QVector<LogField> LogFields;
+
+} // end namespace QsLogging
+
+#endif // QSLOGFIELD_H
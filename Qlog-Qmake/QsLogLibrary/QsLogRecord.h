@@ -0,0 +1,121 @@
+﻿#ifndef QSLOGRECORD_H
+#define QSLOGRECORD_H
+
+#include "QsLogLevel.h"
+#include "QsLogDest.h"
+#include "QsLogField.h"
+#include <QByteArray>
+#include <QDateTime>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+namespace QsLogging
+{
+struct LogSite;
+class LoggerImpl;
+class RecordEncoder;
+class RecordPool;
+
+// 日志记录的元数据，由日志宏在调用点采集
+struct QSLOG_SHARED_OBJECT LogMetadata
+{
+    LogMetadata() : site(nullptr), timestamp(0), threadId(0), sequence(0) {}
+
+    const LogSite* site;  // 调用点的静态信息（文件名、行号、函数、类别），可能为空
+    qint64 timestamp;     // 调用点的单调时钟纳秒读数（见 QsLogClock.h）
+    quint64 threadId;     // 写日志的线程标识（QThread::currentThreadId()）
+    QString threadName;   // 写日志的线程名称，未命名时为空
+    quint64 sequence;     // 写入线程按写出顺序分配的序号，从 1 开始单调递增，0 表示尚未分配
+};
+
+// 一条日志记录：时间戳、级别、线程、调用点和消息内容。
+// 记录在日志宏的调用线程上创建一次，以引用计数共享，所有日志目标收到的是同一个对象，不会逐个拷贝。
+// 延迟格式化和结构化日志的内容由写入线程在交给日志目标之前还原，此后记录不再改变。
+// 日志宏创建的记录取自对象池，连同消息缓冲区一起复用，稳定运行时不分配堆内存。
+class QSLOG_SHARED_OBJECT LogRecord
+{
+public:
+    // 创建一条内容完整的记录
+    LogRecord(Level level, const LogMetadata& metadata, const QString& message,
+              const LogFields& fields = LogFields());
+    // 复制记录的内容，副本不属于对象池
+    LogRecord(const LogRecord& other);
+
+    Level level() const { return m_level; }
+    const LogMetadata& metadata() const { return m_metadata; }
+    // 调用点的单调时钟纳秒读数，以及换算后的本地时间
+    qint64 timestamp() const { return m_metadata.timestamp; }
+    QDateTime dateTime() const;
+    quint64 threadId() const { return m_metadata.threadId; }
+    const QString& threadName() const { return m_metadata.threadName; }
+    // 写入线程分配的序号，与 Logger::committedSequence() 比较即可判断记录是否已经持久化
+    quint64 sequence() const { return m_metadata.sequence; }
+    // 调用点信息，没有调用点时分别为空指针、0、空指针、空指针
+    const LogSite* site() const { return m_metadata.site; }
+    const char* file() const;
+    int line() const;
+    const char* function() const;
+    const char* category() const;
+    // 消息文本（只含动态部分，不含文件、行号）与结构化字段
+    const QString& message() const { return m_message; }
+    const LogFields& fields() const { return m_fields; }
+
+    // 估算记录占用的内存字节数，用于队列的字节预算
+    qint64 approximateSize() const;
+
+private:
+    friend class LoggerImpl;
+    // 崩溃转储与持久化日志环直接保存尚未还原的原始内容
+    friend class RecordEncoder;
+    // 引用计数与对象池的复用
+    friend class LogRecordPtr;
+    friend class RecordPool;
+
+    // 记录内容的编码方式
+    enum Encoding
+    {
+        PlainText,         // message 已是最终文本
+        DeferredArguments, // payload 为 DeferredStream 的参数记录
+        StructuredFields   // payload 为 StructuredStream 的消息与字段记录
+    };
+
+    // 对象池中的空记录
+    LogRecord();
+    LogRecord& operator=(const LogRecord&);
+    // 还原延迟格式化或结构化的内容，只由写入线程调用
+    void decode();
+
+    Level m_level;
+    LogMetadata m_metadata;
+    QString m_message;
+    LogFields m_fields;
+    Encoding m_encoding;
+    QByteArray m_payload;
+    mutable std::atomic_int m_refCount; // LogRecordPtr 的引用计数
+    bool m_pooled;                      // 是否属于对象池，引用释放后回到池中而不是被删除
+};
+
+// 从其他进程留下的文件（崩溃转储或持久化日志环）中恢复的一条记录，内容已经还原，
+// 时间已换算为自 1970-01-01 UTC 起的纳秒数
+struct QSLOG_SHARED_OBJECT RecoveredRecord
+{
+    RecoveredRecord() : level(TraceLevel), epochNanoseconds(0), threadId(0), sequence(0), line(0) {}
+
+    Level level;
+    qint64 epochNanoseconds;
+    quint64 threadId;
+    QString threadName;
+    quint64 sequence;     // 原进程中写入线程分配的序号，0 表示记录当时仍在队列中
+    QString file;         // 调用点信息，没有调用点时为空
+    int line;
+    QString function;
+    QString format;
+    QString category;
+    QString message;
+    LogFields fields;
+};
+
+} // end namespace QsLogging
+
+#endif // QSLOGRECORD_H
@@ -0,0 +1,55 @@
+﻿#ifndef QSLOGRECORDPOOL_H
+#define QSLOGRECORDPOOL_H
+
+#include "QsLogRecord.h"
+#include "QsLogRingBuffer.h"
+#include <QMutex>
+#include <QVector>
+#include <atomic>
+
+namespace QsLogging
+{
+
+// 日志宏创建的记录的对象池。记录按 slab 成批分配且不再释放，引用释放后连同消息与参数缓冲区的容量一起回到池中，
+// 稳定运行时创建记录既不分配堆内存，也不会由写入线程释放调用线程分配的内存。
+// 空闲记录保存在无锁环形缓冲区中，任意线程都可以取出与归还；池中的记录达到上限后改为单独分配，用完即删除
+class RecordPool
+{
+public:
+    // 每个 slab 包含的记录数
+    static const int SlabRecords = 256;
+    // 池中记录总数的上限
+    static const int MaxPooledRecords = 16 * 1024;
+    // 每条记录预留的消息字符数与参数字节数，短消息无需扩容
+    static const int InlineMessageCapacity = 128;
+    static const int InlinePayloadCapacity = 256;
+    // 回收时保留的最大容量，超过时释放缓冲区，偶尔出现的长消息不会一直占用内存
+    static const int RetainedCapacity = 4096;
+
+    // 进程内唯一的对象池，第一次使用时创建，之后一直存在，进程退出时仍可以归还记录
+    static RecordPool& instance();
+
+    // 取出一条空记录
+    LogRecord* acquire();
+    // 归还最后一个引用已经释放的记录
+    void recycle(LogRecord* record);
+    // 已分配的 slab 数
+    int slabCount() const;
+
+private:
+    RecordPool();
+    RecordPool(const RecordPool&);
+    RecordPool& operator=(const RecordPool&);
+
+    // 分配一个新的 slab 并放入空闲列表，达到上限时返回 false
+    bool grow();
+
+    RingBuffer<LogRecord*> m_free; // 空闲记录
+    mutable QMutex m_growMutex;    // 保护 slab 列表，只在空闲记录用完时使用
+    QVector<LogRecord*> m_slabs;   // 已分配的 slab
+    std::atomic_int m_slabCount;
+};
+
+} // end namespace QsLogging
+
+#endif // QSLOGRECORDPOOL_H
@@ -0,0 +1,306 @@
+﻿#ifndef QSLOGRINGBUFFER_H
+#define QSLOGRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace QsLogging
+{
+
+// 缓存行大小，用于隔离生产者与消费者频繁修改的游标，避免伪共享
+static const size_t CacheLineSize = 64;
+
+// 有界无锁环形缓冲区（多生产者/单消费者）
+// 所有槽位在构造时一次性分配，每个槽位携带一个序号，
+// 生产者通过 CAS 抢占写入位置，消费者通过序号判断槽位是否已就绪。
+// 算法本身也允许多个消费者：日志队列只由写入线程出队，记录对象池的空闲列表则由各个日志线程出队。
+template <typename T>
+class RingBuffer
+{
+public:
+    // 容量会向上取整为 2 的幂，便于用掩码代替取模
+    explicit RingBuffer(size_t capacity)
+        : m_slots(0)
+        , m_mask(roundUpToPowerOfTwo(capacity) - 1)
+        , m_head(0)
+        , m_tail(0)
+    {
+        m_slots = new Slot[m_mask + 1];
+        for (size_t i = 0; i <= m_mask; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~RingBuffer()
+    {
+        delete[] m_slots;
+    }
+
+    // 尝试入队，缓冲区已满时返回 false，不会阻塞
+    bool tryPush(T&& value)
+    {
+        Slot* slot;
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        for (;;) {
+            slot = &m_slots[pos & m_mask];
+            const size_t seq = slot->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                // 槽位空闲，尝试占用该位置
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // 消费者尚未释放该槽位，缓冲区已满
+                return false;
+            } else {
+                // 其他生产者已抢先占用，重新读取写入位置
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::move(value);
+        // 发布槽位，消费者看到新序号后即可读取
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 尝试出队，缓冲区为空时返回 false
+    bool tryPop(T& value)
+    {
+        Slot* slot;
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            slot = &m_slots[pos & m_mask];
+            const size_t seq = slot->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // 该槽位还没有被生产者发布，缓冲区为空
+                return false;
+            } else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(slot->value);
+        // 释放槽位，序号推进一整圈后生产者才能再次写入
+        slot->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 查看队首元素而不取出，队首尚未发布时返回空指针。仅允许唯一的消费者调用
+    const T* front() const
+    {
+        const size_t pos = m_tail.load(std::memory_order_relaxed);
+        const Slot& slot = m_slots[pos & m_mask];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return nullptr;
+        }
+        return &slot.value;
+    }
+
+    // 近似判断是否为空，仅用于等待与刷新时的快速检查
+    bool isEmpty() const
+    {
+        return m_tail.load(std::memory_order_acquire) >= m_head.load(std::memory_order_acquire);
+    }
+
+    // 近似的当前元素个数
+    size_t size() const
+    {
+        const size_t head = m_head.load(std::memory_order_acquire);
+        const size_t tail = m_tail.load(std::memory_order_acquire);
+        return head > tail ? head - tail : 0;
+    }
+
+    // 累计入队（生产者已占用）与出队的元素个数，用于刷新屏障判断某一时刻之前入队的元素是否都已取出
+    size_t pushedCount() const
+    {
+        return m_head.load(std::memory_order_acquire);
+    }
+
+    size_t poppedCount() const
+    {
+        return m_tail.load(std::memory_order_acquire);
+    }
+
+    // 依次访问尚未出队的元素而不取出。不加锁、不分配内存，供崩溃处理函数使用；
+    // 与生产者、消费者并发时结果是近似的，尚未发布或已被取走的槽位会被跳过
+    template <typename Visitor>
+    void peek(Visitor visitor) const
+    {
+        const size_t head = m_head.load(std::memory_order_acquire);
+        for (size_t pos = m_tail.load(std::memory_order_acquire); pos < head; ++pos) {
+            const Slot& slot = m_slots[pos & m_mask];
+            if (slot.sequence.load(std::memory_order_acquire) == pos + 1) {
+                visitor(slot.value);
+            }
+        }
+    }
+
+    size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+private:
+    RingBuffer(const RingBuffer&);
+    RingBuffer& operator=(const RingBuffer&);
+
+    static size_t roundUpToPowerOfTwo(size_t value)
+    {
+        size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    Slot* m_slots;
+    const size_t m_mask;
+    // 生产者游标与消费者游标各占独立的缓存行
+    char m_padBeforeHead[CacheLineSize];
+    std::atomic<size_t> m_head;
+    char m_padBeforeTail[CacheLineSize - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> m_tail;
+    char m_padAfterTail[CacheLineSize - sizeof(std::atomic<size_t>)];
+};
+
+// 有界无锁环形缓冲区（单生产者/单消费者）
+// 用作每个日志线程私有的暂存缓冲区：生产者只修改写入游标，消费者只修改读取游标，
+// 双方各自缓存对方的游标，只有在缓存值显示已满/已空时才去读取对方所在的缓存行。
+template <typename T>
+class SpscRingBuffer
+{
+public:
+    // 容量会向上取整为 2 的幂，便于用掩码代替取模
+    explicit SpscRingBuffer(size_t capacity)
+        : m_slots(0)
+        , m_mask(roundUpToPowerOfTwo(capacity) - 1)
+        , m_head(0)
+        , m_cachedTail(0)
+        , m_tail(0)
+        , m_cachedHead(0)
+    {
+        m_slots = new T[m_mask + 1];
+    }
+
+    ~SpscRingBuffer()
+    {
+        delete[] m_slots;
+    }
+
+    // 尝试入队，仅允许所属的生产者线程调用
+    bool tryPush(T&& value)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_cachedTail > m_mask) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cachedTail > m_mask) {
+                return false;
+            }
+        }
+        m_slots[head & m_mask] = std::move(value);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 尝试出队，仅允许消费者线程调用
+    bool tryPop(T& value)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_cachedHead) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail == m_cachedHead) {
+                return false;
+            }
+        }
+        value = std::move(m_slots[tail & m_mask]);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 查看队首元素而不取出，队列为空时返回空指针。仅允许消费者线程调用
+    const T* front()
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_cachedHead) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail == m_cachedHead) {
+                return nullptr;
+            }
+        }
+        return &m_slots[tail & m_mask];
+    }
+
+    // 近似判断是否为空，任意线程都可以调用
+    bool isEmpty() const
+    {
+        return m_tail.load(std::memory_order_acquire) >= m_head.load(std::memory_order_acquire);
+    }
+
+    // 累计入队（生产者已占用）与出队的元素个数，用于刷新屏障判断某一时刻之前入队的元素是否都已取出
+    size_t pushedCount() const
+    {
+        return m_head.load(std::memory_order_acquire);
+    }
+
+    size_t poppedCount() const
+    {
+        return m_tail.load(std::memory_order_acquire);
+    }
+
+    // 依次访问尚未出队的元素而不取出。不加锁、不分配内存，供崩溃处理函数使用；
+    // 与消费者并发时可能读到正在被取走的元素
+    template <typename Visitor>
+    void peek(Visitor visitor) const
+    {
+        const size_t head = m_head.load(std::memory_order_acquire);
+        for (size_t pos = m_tail.load(std::memory_order_acquire); pos < head; ++pos) {
+            visitor(m_slots[pos & m_mask]);
+        }
+    }
+
+    size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+private:
+    SpscRingBuffer(const SpscRingBuffer&);
+    SpscRingBuffer& operator=(const SpscRingBuffer&);
+
+    static size_t roundUpToPowerOfTwo(size_t value)
+    {
+        size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    T* m_slots;
+    const size_t m_mask;
+    // 生产者独占的缓存行：写入游标及其缓存的读取游标
+    char m_padBeforeHead[CacheLineSize];
+    std::atomic<size_t> m_head;
+    size_t m_cachedTail;
+    char m_padBeforeTail[CacheLineSize - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+    // 消费者独占的缓存行：读取游标及其缓存的写入游标
+    std::atomic<size_t> m_tail;
+    size_t m_cachedHead;
+    char m_padAfterTail[CacheLineSize - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+};
+
+} // end namespace QsLogging
+
+#endif // QSLOGRINGBUFFER_H
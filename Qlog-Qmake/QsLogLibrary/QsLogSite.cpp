@@ -0,0 +1,62 @@
+﻿#include "QsLogSite.h"
+#include <QMutex>
+
+namespace QsLogging
+{
+
+namespace
+{
+
+// 注册表数据。有意不释放：调用点可能在静态对象析构阶段仍在写日志
+struct SiteRegistryData
+{
+    QMutex mutex;
+    QVector<const LogSite*> sites;
+};
+
+SiteRegistryData& registryData()
+{
+    static SiteRegistryData* data = new SiteRegistryData;
+    return *data;
+}
+
+} // end anonymous namespace
+
+const LogSite* LogSiteRegistry::registerSite(const char* file, int line, const char* function,
+                                             Level level, const char* format, int flags,
+                                             const char* category)
+{
+    SiteRegistryData& data = registryData();
+    QMutexLocker locker(&data.mutex);
+    LogSite* site = new LogSite;
+    site->id = static_cast<quint32>(data.sites.size() + 1);
+    site->file = file;
+    site->line = line;
+    site->function = function;
+    site->level = level;
+    site->format = format;
+    site->category = category;
+    site->flags = flags;
+    site->suppressed.store(0, std::memory_order_relaxed);
+    data.sites.append(site);
+    return site;
+}
+
+const LogSite* LogSiteRegistry::site(quint32 id)
+{
+    SiteRegistryData& data = registryData();
+    QMutexLocker locker(&data.mutex);
+    if (id == 0 || id > static_cast<quint32>(data.sites.size())) {
+        return nullptr;
+    }
+    return data.sites.at(static_cast<int>(id - 1));
+}
+
+QVector<const LogSite*> LogSiteRegistry::sites()
+{
+    SiteRegistryData& data = registryData();
+    QMutexLocker locker(&data.mutex);
+    return data.sites;
+}
+
+} // end namespace
@@ -0,0 +1,88 @@
+﻿#ifndef QSLOGSITE_H
+#define QSLOGSITE_H
+
+#include "QsLogLevel.h"
+#include "QsLogDest.h"
+#include <QVector>
+#include <QtGlobal>
+#include <atomic>
+#include <cstddef>
+
+namespace QsLogging
+{
+
+// 日志调用点的静态信息。每个 QLOG_* 调用点在首次执行时登记一次，
+// 之后每条日志只携带指向它的指针，文件、行号等信息不再重复进入队列和存储。
+struct QSLOG_SHARED_OBJECT LogSite
+{
+    enum Flag
+    {
+        NoFlags      = 0,
+        ShowLocation = 0x1, // 文本输出时在消息前加上 "文件@行号"（QS_LOG_LINE_NUMBERS）
+        RateLimited  = 0x2  // 限流日志宏的调用点，写入线程会定期汇总其被抑制的次数
+    };
+
+    quint32 id;           // 进程内唯一的调用点编号，从 1 开始
+    const char* file;     // 源文件名（__FILE__ 去掉目录部分）
+    int line;             // 行号（__LINE__）
+    const char* function; // 所在函数（Q_FUNC_INFO）
+    Level level;          // 日志级别
+    const char* format;   // 格式字符串字面量，流式日志为空
+    const char* category; // 所属类别的名称，未使用类别时为空
+    int flags;            // Flag 的组合
+    mutable std::atomic<quint64> suppressed; // 上次汇总以来被限流抑制的次数
+};
+
+// 进程级的调用点注册表，登记后的 LogSite 在进程结束前始终有效
+class QSLOG_SHARED_OBJECT LogSiteRegistry
+{
+public:
+    // 登记一个调用点并返回其静态信息，由日志宏在每个调用点只调用一次
+    static const LogSite* registerSite(const char* file, int line, const char* function,
+                                       Level level, const char* format, int flags,
+                                       const char* category = nullptr);
+    // 按编号查找调用点，编号无效时返回空指针
+    static const LogSite* site(quint32 id);
+    // 获取当前已登记的所有调用点
+    static QVector<const LogSite*> sites();
+};
+
+// -- 编译期计算源文件名 --
+// 按二分递归查找路径中最后一个分隔符，递归深度只有路径长度的对数，不受编译器 constexpr 递归深度限制
+constexpr const char* preferNonNull(const char* first, const char* second)
+{
+    return first ? first : second;
+}
+
+// 返回 [begin, end) 中最后一个 '/' 或 '\\' 之后的位置，没有分隔符时返回空指针
+constexpr const char* afterLastSeparator(const char* begin, const char* end)
+{
+    return end - begin == 0 ? nullptr
+         : end - begin == 1 ? ((*begin == '/' || *begin == '\\') ? begin + 1 : nullptr)
+         : preferNonNull(afterLastSeparator(begin + (end - begin) / 2, end),
+                         afterLastSeparator(begin, begin + (end - begin) / 2));
+}
+
+// 返回路径中的文件名部分，length 为路径长度
+constexpr const char* sourceBasename(const char* path, size_t length)
+{
+    return preferNonNull(afterLastSeparator(path, path + length), path);
+}
+
+} // end namespace QsLogging
+
+// 当前源文件名，不含目录
+#define QS_LOG_FILE QsLogging::sourceBasename(__FILE__, sizeof(__FILE__) - 1)
+
+// 获取当前调用点的 LogSite：函数名和类别名在外层求值，静态局部变量保证每个调用点只登记一次
+#define QS_LOG_CATEGORY_SITE(category, level, format, flags) \
+    [](const char* qsLogFunction, const char* qsLogCategory) -> const QsLogging::LogSite* { \
+        static constexpr const char* qsLogFile = QS_LOG_FILE; \
+        static const QsLogging::LogSite* const qsLogSite = QsLogging::LogSiteRegistry::registerSite( \
+            qsLogFile, __LINE__, qsLogFunction, level, format, flags, qsLogCategory); \
+        return qsLogSite; \
+    }(Q_FUNC_INFO, category)
+#define QS_LOG_SITE(level, format, flags) \
+    QS_LOG_CATEGORY_SITE(nullptr, level, format, flags)
+
+#endif // QSLOGSITE_H
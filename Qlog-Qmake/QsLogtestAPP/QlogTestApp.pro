@@ -1,31 +1,47 @@
-# TEMPLATE = app
-TEMPLATE = app
-
-# 目标文件名
-TARGET = QlogTestApp
-
-# 添加所需的 Qt 模块
-QT += core widgets sql
-
-# 启用 C++11 支持
-CONFIG += c++11
-
-# 只包含应用程序自身的源文件
-SOURCES += \
-    main.cpp
-
-win32:CONFIG(release, debug|release): LIBS += -L$$PWD/./ -lQsLogLibrary
-else:win32:CONFIG(debug, debug|release): LIBS += -L$$PWD/./ -lQsLogLibrary
-else:unix: LIBS += -L$$PWD/./ -lQsLogLibrary
-
-INCLUDEPATH += $$PWD/.
-DEPENDPATH += $$PWD/.
-
-HEADERS += \
-    QsLog.h \
-    QsLogDest.h \
-    QsLogDestConsole.h \
-    QsLogDestFile.h \
-    QsLogDestFunctor.h \
-    QsLogDisableForThisFile.h \
-    QsLogLevel.h
+# TEMPLATE = app
+TEMPLATE = app
+
+# 目标文件名
+TARGET = QlogTestApp
+
+# 添加所需的 Qt 模块
+QT += core widgets sql
+
+# 启用 C++11 支持
+CONFIG += c++11
+
+# 编译期最低日志级别（0=TRACE ... 6=OFF），低于该级别的 QLOG_* 语句不会编入二进制
+# 可在命令行覆盖：qmake QS_LOG_COMPILE_LEVEL=2
+isEmpty(QS_LOG_COMPILE_LEVEL): QS_LOG_COMPILE_LEVEL = 0
+DEFINES += QS_LOG_COMPILE_LEVEL=$$QS_LOG_COMPILE_LEVEL
+
+# 只包含应用程序自身的源文件
+SOURCES += \
+    main.cpp
+
+win32:CONFIG(release, debug|release): LIBS += -L$$PWD/./ -lQsLogLibrary
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$PWD/./ -lQsLogLibrary
+else:unix: LIBS += -L$$PWD/./ -lQsLogLibrary
+
+INCLUDEPATH += $$PWD/.
+DEPENDPATH += $$PWD/.
+
+HEADERS += \
+    QsLog.h \
+    QsLogArguments.h \
+    QsLogCategory.h \
+    QsLogClock.h \
+    QsLogCrash.h \
+    QsLogDest.h \
+    QsLogDestAsync.h \
+    QsLogDestConsole.h \
+    QsLogDestFile.h \
+    QsLogDestFunctor.h \
+    QsLogDisableForThisFile.h \
+    QsLogField.h \
+    QsLogFormat.h \
+    QsLogJournal.h \
+    QsLogLevel.h \
+    QsLogLimiter.h \
+    QsLogRecord.h \
+    QsLogSite.h
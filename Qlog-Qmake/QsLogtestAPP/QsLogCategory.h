@@ -0,0 +1,58 @@
+﻿#ifndef QSLOGCATEGORY_H
+#define QSLOGCATEGORY_H
+
+#include "QsLogLevel.h"
+#include "QsLogDest.h"
+#include <QString>
+#include <atomic>
+
+namespace QsLogging
+{
+class Logger;
+
+// 命名日志类别，每个类别拥有独立的运行时级别。
+// 类别名按 "." 分层，例如 "net"、"net.http"；没有匹配规则的类别跟随 Logger 的全局级别。
+// 级别检查只有一次 relaxed 原子读取，由 QLOG_CAT_XXX(category) 宏内联调用。
+class QSLOG_SHARED_OBJECT Category
+{
+public:
+    // name 必须在类别的整个生命周期内有效，通常使用字符串字面量
+    explicit Category(const char* name);
+    ~Category();
+
+    // 类别名称
+    const char* name() const { return m_name; }
+    // 判断该类别下指定级别的日志是否需要输出
+    bool isLevelEnabled(Level level) const
+    {
+        return static_cast<int>(level) >= m_threshold.load(std::memory_order_relaxed);
+    }
+    // 获取该类别当前生效的级别
+    Level level() const;
+
+    // 设置类别规则，替换之前的全部规则。规则之间以 ';'、',' 或换行分隔，例如
+    // "net.*=debug;net.http=warn;*=info"。"前缀.*" 匹配该类别本身及其所有子类别，
+    // "*" 匹配所有类别；级别取 trace/debug/info/warn/error/fatal/off，
+    // default 表示跟随全局级别。多条规则同时匹配时以最后一条为准。
+    static void setRules(const QString& rules);
+    // 追加一条规则
+    static void setLevel(const QString& pattern, Level level);
+    // 清除所有规则，所有类别恢复跟随全局级别
+    static void resetRules();
+
+private:
+    Category(const Category&);
+    Category& operator=(const Category&);
+
+    friend class Logger;
+    // 全局级别变化时由 Logger 调用，更新所有跟随全局级别的类别
+    static void setDefaultLevel(Level level);
+    friend struct CategoryRegistryData;
+
+    const char* m_name;
+    std::atomic<int> m_threshold; // 当前生效的级别
+};
+
+} // end namespace QsLogging
+
+#endif // QSLOGCATEGORY_H
@@ -3,6 +3,7 @@
 
 #include "QsLogLevel.h"
 #include <QSharedPointer>
+#include <QVector>
 #include <QtGlobal>
 class QString;
 class QObject;
@@ -21,6 +22,55 @@ class QObject;
 
 namespace QsLogging
 {
+class LogRecord;
+// 共享的只读日志记录。引用计数保存在记录内部，复制指针不分配内存；
+// 最后一个引用释放时，日志宏创建的记录回到对象池中复用（见 QsLogRecordPool.h），其他记录被删除
+class QSLOG_SHARED_OBJECT LogRecordPtr
+{
+public:
+    LogRecordPtr() : m_record(nullptr) {}
+    // 接管一条新建的记录，例如 LogRecordPtr(new LogRecord(...))
+    explicit LogRecordPtr(const LogRecord* record);
+    LogRecordPtr(const LogRecordPtr& other);
+    LogRecordPtr(LogRecordPtr&& other) : m_record(other.m_record) { other.m_record = nullptr; }
+    ~LogRecordPtr() { clear(); }
+    LogRecordPtr& operator=(const LogRecordPtr& other);
+    // 释放原来的记录并接管 other 的记录，other 随后为空；不能交换，
+    // 否则从环形缓冲区取出时原来的记录会留在槽位中，直到槽位被覆盖才回到对象池
+    LogRecordPtr& operator=(LogRecordPtr&& other)
+    {
+        if (this != &other) {
+            clear();
+            m_record = other.m_record;
+            other.m_record = nullptr;
+        }
+        return *this;
+    }
+
+    const LogRecord* data() const { return m_record; }
+    const LogRecord* operator->() const { return m_record; }
+    const LogRecord& operator*() const { return *m_record; }
+    bool isNull() const { return m_record == nullptr; }
+    explicit operator bool() const { return m_record != nullptr; }
+    // 释放引用并置空
+    void clear()
+    {
+        if (m_record) {
+            release();
+        }
+    }
+
+private:
+    // 写入线程在交给日志目标之前为记录分配序号并还原内容
+    friend class LoggerImpl;
+
+    LogRecord* mutableData() const { return m_record; }
+    void release();
+
+    LogRecord* m_record;
+};
+// 写入线程一次交给日志目标的一批记录
+typedef QVector<LogRecordPtr> LogRecordList;
 
 // 日志目标抽象基类
 class QSLOG_SHARED_OBJECT Destination
@@ -34,8 +84,18 @@ public:
     virtual ~Destination();
     // 纯虚函数，用于将日志消息写入目标
     virtual void write(const QString& message, Level level) = 0;
+    // 写入一条日志记录。记录由所有目标共享，目标不应保存对它的引用。
+    // 默认实现把记录转换为文本（按调用点加上文件、行号和类别，在末尾加上 "键=值" 形式的字段）后调用 write()，
+    // 只实现了 write() 的目标无需修改；能够单独保存时间戳、线程、调用点和字段的目标（例如数据库）可以重写此函数
+    virtual void writeRecord(const LogRecord& record);
+    // 写入一批记录，同一线程写的记录保持先后顺序。写入线程每轮把取到的所有记录一次交给每个目标，
+    // 默认实现逐条调用 writeRecord()；可以合并写入的目标（例如数据库使用一个事务）可以重写此函数
+    virtual void writeBatch(const LogRecordList& records);
     // 纯虚函数，用于检查目标是否有效
     virtual bool isValid() = 0;
+    // 把已经写入的记录持久化（例如把缓冲写入磁盘），成功时返回 true。
+    // 只在 Logger::flush() 等刷新请求时由写入线程调用，常规写入路径不会调用；默认实现直接返回 true
+    virtual bool sync();
 };
 // Destination 智能指针类型定义
 typedef QSharedPointer<Destination> DestinationPtr;
@@ -86,6 +146,9 @@ public:
     static DestinationPtr MakeFunctorDestination(Destination::LogFunction f);
     // 创建基于 QObject 成员函数的日志目标的静态方法
     static DestinationPtr MakeFunctorDestination(QObject *receiver, const char *member);
+    // 创建在独立线程上运行 destination 的异步日志目标（见 QsLogDestAsync.h）
+    static DestinationPtr MakeAsyncDestination(const DestinationPtr& destination, int queueCapacity = 8192,
+                                               bool blockWhenFull = false);
 };
 
 } // end namespace QsLogging
@@ -0,0 +1,63 @@
+﻿#ifndef QSLOGDESTASYNC_H
+#define QSLOGDESTASYNC_H
+
+#include "QsLogDest.h"
+#include <QtGlobal>
+
+namespace QsLogging
+{
+class AsyncDestinationImpl;
+
+// 异步目标各自的运行统计
+struct QSLOG_SHARED_OBJECT AsyncDestinationStatistics
+{
+    AsyncDestinationStatistics() :
+        queued(0), written(0), dropped(0), lastLagNanoseconds(0), maxLagNanoseconds(0) {}
+
+    quint64 queued;            // 已入队但尚未写完的记录数
+    quint64 written;           // 已写入被包装目标的记录数
+    quint64 dropped;           // 队列已满而被丢弃的记录数
+    qint64 lastLagNanoseconds; // 最近写完的一批中，记录从调用点到写入完成的最大延迟
+    qint64 maxLagNanoseconds;  // 自上次重置以来的最大延迟
+};
+
+// 异步日志目标：包装另一个目标，使其在独立的线程上运行。
+// 日志写入线程只把记录的共享指针放入本目标的有界队列，随即返回处理其他目标，
+// 被包装目标的慢速写入（例如数据库提交）不会拖慢控制台等其他目标。
+// 队列已满时默认丢弃新记录并计数，也可以选择阻塞等待（此时慢速目标仍会拖慢写入线程）。
+// 队列为单生产者队列，写入函数只应由日志写入线程调用，即通过 Logger::addDestination() 添加后使用。
+class QSLOG_SHARED_OBJECT AsyncDestination : public Destination
+{
+public:
+    // destination 为被包装的目标，此后只应由本目标的线程访问；queueCapacity 为队列可容纳的记录数
+    explicit AsyncDestination(const DestinationPtr& destination, int queueCapacity = 8192,
+                              bool blockWhenFull = false);
+    // 写完队列中剩余的记录后结束线程
+    ~AsyncDestination();
+
+    void write(const QString& message, Level level) override;
+    // 单条写入需要拷贝一份记录，常规路径走 writeBatch()
+    void writeRecord(const LogRecord& record) override;
+    // 只把记录的共享指针放入队列，不拷贝记录
+    void writeBatch(const LogRecordList& records) override;
+    bool isValid() override;
+    // 等待工作线程写完此前入队的记录，并在工作线程上调用被包装目标的 sync()
+    bool sync() override;
+
+    // 等待调用时已入队的记录全部写完，可由任意线程调用；timeoutMs 小于 0 表示一直等待，超时返回 false
+    bool waitForIdle(int timeoutMs = -1);
+    // 获取运行统计
+    AsyncDestinationStatistics statistics() const;
+    // 重置丢弃数和最大延迟
+    void resetStatistics();
+
+private:
+    AsyncDestination(const AsyncDestination&);
+    AsyncDestination& operator=(const AsyncDestination&);
+
+    AsyncDestinationImpl* d;
+};
+
+} // end namespace QsLogging
+
+#endif // QSLOGDESTASYNC_H
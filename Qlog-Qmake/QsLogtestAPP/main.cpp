@@ -9,7 +9,10 @@
 #include <QElapsedTimer>
 #include <thread>
 #include "QsLog.h"
+#include "QsLogCrash.h"
+#include "QsLogDestAsync.h"
 #include "QsLogDestFile.h"
+#include "QsLogJournal.h"
 
 // 使用线程安全的原子计数器，避免竞态条件
 std::atomic<long long int> count(0);
@@ -19,6 +22,8 @@ std::atomic<bool> stopRequested(false);
 // 日志生成函数，模拟多线程并发写入
 void logGenerator(int threadId)
 {
+    // 线程池中的线程没有名称，为日志记录中的 thread_name 指定一个便于识别的名称
+    QsLogging::Logger::setThreadName(QString("generator-%1").arg(threadId));
     for(int i = 0;i < 1000;i++)
     {
         // 定期检查是否收到停止信号，每1000次迭代检查一次
@@ -41,11 +46,43 @@ void logGenerator(int threadId)
         } else {
             QLOG_ERROR() << "Thread " << threadId << ": This is an ERROR message number " << i;
         }
+        // 限流日志：每个调用点每 100 次只输出一次，被抑制的次数由写入线程定期汇总
+        QLOG_WARN_EVERY_N(100) << "Thread " << threadId << ": This is a throttled WARNING message number " << i;
+        QLOG_INFO_ONCE() << "Thread " << threadId << ": first message of the stress test";
+        // 结构化日志：字段以类型化的值写入数据库的 log_fields 表
+        if (i % 100 == 0) {
+            QLOG_INFO("stress progress").kv("thread", threadId).kv("iteration", i);
+        }
 
         count++; // 每次成功写入日志，计数加1
     }
 }
 
+// 对比 QDebug 流式日志宏与格式化日志宏在调用线程上的单条开销，两者生成的文本相同。
+// 在添加输出目标之前运行，写入线程只负责出队，计时结果主要是格式化和入队的开销
+void benchmarkFormatting(QsLogging::Logger& logger)
+{
+    const int iterations = 100000;
+    QElapsedTimer timer;
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        QLOG_INFO() << "conn" << i << "took" << i * 3 << "us, ratio" << i * 0.001;
+    }
+    const qint64 streamNs = timer.nsecsElapsed();
+    logger.flush();
+
+    timer.restart();
+    for (int i = 0; i < iterations; ++i) {
+        QLOG_INFOF("conn {} took {} us, ratio {}", i, i * 3, i * 0.001);
+    }
+    const qint64 formatNs = timer.nsecsElapsed();
+    logger.flush();
+
+    qDebug() << "Per-call cost: QDebug stream" << streamNs / iterations << "ns, format string"
+             << formatNs / iterations << "ns";
+}
+
 int main(int argc, char *argv[])
 {
     QCoreApplication a(argc, argv);
@@ -60,16 +97,47 @@ int main(int argc, char *argv[])
     QsLogging::Logger& logger = QsLogging::Logger::instance();
     // 设置日志级别为Trace，显示所有日志
     logger.setLoggingLevel(QsLogging::TraceLevel);
+    // 进程退出时最多等待 10 秒写完剩余的日志（由 Logger 登记的 aboutToQuit/atexit 钩子完成）
+    logger.setShutdownTimeout(10000);
+    // FATAL 日志写入并同步数据库后才返回，随后即使 abort() 也能在 log.db 中找到它
+    logger.setSynchronousLevel(QsLogging::FatalLevel, 10000);
+    // 写入线程以 nice 5 运行并固定在最后一个核心上，不与处理请求的线程争抢 CPU
+    QsLogging::WriterThreadOptions writerOptions;
+    writerOptions.niceValue = 5;
+    const int cpuCount = QThread::idealThreadCount();
+    if (cpuCount > 1 && cpuCount <= 64) {
+        writerOptions.cpuAffinityMask = quint64(1) << (cpuCount - 1);
+    }
+    logger.setWriterThreadOptions(writerOptions);
+
+    // 添加输出目标之前先测量格式化的开销
+    benchmarkFormatting(logger);
 
     // 创建控制台输出目标
     QsLogging::DestinationPtr debugDestination(
         QsLogging::DestinationFactory::MakeDebugOutputDestination());
     logger.addDestination(debugDestination);
 
-    // 创建SQLite数据库文件输出目标
+    // 创建SQLite数据库文件输出目标，放在独立的线程上写入，数据库提交不会拖慢控制台输出
     const QString dbLogPath = logDir.absoluteFilePath("log.db");
-    QsLogging::DestinationPtr dbFileDestination(
-        new QsLogging::DatabaseDestination(dbLogPath)
+    QsLogging::DatabaseDestinationPtr database(new QsLogging::DatabaseDestination(dbLogPath));
+    // 上次运行崩溃时转储的日志先补写进数据库，然后为本次运行重新安装崩溃处理函数
+    const QString crashDumpPath = logDir.absoluteFilePath("crash.dump");
+    const int recovered = QsLogging::CrashHandler::mergeIntoDatabase(crashDumpPath, *database);
+    if (recovered > 0) {
+        qDebug() << "Recovered" << recovered << "log records from the previous crash";
+    }
+    QsLogging::CrashHandler::install(crashDumpPath);
+    // 进程被强制结束（SIGKILL、OOM）时，尚未刷新确认的日志（包括仍在队列中的）留在持久化日志环中，
+    // 启用日志环之前必须先恢复，否则 enableJournal() 拒绝清空文件
+    const QString journalPath = logDir.absoluteFilePath("journal.bin");
+    const int replayed = QsLogging::Journal::recoverIntoDatabase(journalPath, *database);
+    if (replayed > 0) {
+        qDebug() << "Recovered" << replayed << "unflushed log records from the journal";
+    }
+    logger.enableJournal(journalPath);
+    QSharedPointer<QsLogging::AsyncDestination> dbFileDestination(
+        new QsLogging::AsyncDestination(database, 65536)
     );
     logger.addDestination(dbFileDestination);
 
@@ -102,10 +170,23 @@ int main(int argc, char *argv[])
         future.waitForFinished();
     }
 
-    // 在程序退出前，强制将所有待处理日志写入文件
-    logger.flush();
+    // 在程序退出前，等待所有待处理日志写入数据库并同步
+    if (!logger.flush(30000)) {
+        qWarning() << "Flush did not complete within 30 seconds";
+    }
+    qDebug() << "Committed up to sequence" << logger.committedSequence();
 
     QLOG_INFO() << "测试已完成。总日志条数: " << count.load();
 
+    // 输出从调用点到写入数据库的端到端延迟
+    const QsLogging::LatencyStatistics latency = logger.latencyStatistics();
+    qDebug() << "Enqueue-to-persist latency: average"
+             << (latency.count ? latency.totalNanoseconds / qint64(latency.count) / 1000 : 0)
+             << "us, max" << latency.maxNanoseconds / 1000 << "us over" << latency.count << "messages";
+    // 数据库目标自己的队列统计：写入数、丢弃数和最大延迟
+    const QsLogging::AsyncDestinationStatistics dbStatistics = dbFileDestination->statistics();
+    qDebug() << "Database destination: written" << dbStatistics.written << "dropped" << dbStatistics.dropped
+             << "max lag" << dbStatistics.maxLagNanoseconds / 1000 << "us";
+
     return a.exec();
 }